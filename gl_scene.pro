@@ -1,8 +1,8 @@
 QT -= gui
-QT += opengl
+QT += opengl concurrent
 
 TEMPLATE = lib
-CONFIG += staticlib c++11
+CONFIG += staticlib c++17
 DESTDIR = ../bin
 
 # You can make your code fail to compile if it uses deprecated APIs.
@@ -11,33 +11,63 @@ DESTDIR = ../bin
 
 SOURCES += \
     src/gl_scene.cpp \
+    src/gl_scene_batch.cpp \
     src/gl_scene_camera.cpp \
+    src/gl_scene_camera_state.cpp \
+    src/gl_scene_capabilities.cpp \
     src/gl_scene_defaults.cpp \
+    src/gl_scene_frame_scheduler.cpp \
     src/gl_scene_generator.cpp \
-    src/gl_scene_glass.cpp \
     src/gl_scene_item.cpp \
+    src/gl_scene_label_placer.cpp \
     src/gl_scene_loader.cpp \
     src/gl_scene_manipulator.cpp \
     src/gl_scene_mesh.cpp \
+    src/gl_scene_mesh_cache.cpp \
     src/gl_scene_object.cpp \
+    src/gl_scene_occlusion_culler.cpp \
+    src/gl_scene_optimizer.cpp \
+    src/gl_scene_overlay_renderer.cpp \
     src/gl_scene_pipe.cpp \
+    src/gl_scene_program_cache.cpp \
     src/gl_scene_projection.cpp \
+    src/gl_scene_quality_controller.cpp \
+    src/gl_scene_resource_manager.cpp \
+    src/gl_scene_streaming_texture.cpp \
+    src/gl_scene_text_renderer.cpp \
+    src/gl_scene_texture_cache.cpp \
+    src/gl_scene_texture_manager.cpp \
     src/gl_scene_utility.cpp \
     src/gl_scene_view.cpp
 
 HEADERS += \
     inc/gl_scene.h \
+    inc/gl_scene_batch.h \
     inc/gl_scene_camera.h \
+    inc/gl_scene_camera_state.h \
+    inc/gl_scene_capabilities.h \
     inc/gl_scene_defaults.h \
+    inc/gl_scene_frame_scheduler.h \
     inc/gl_scene_generator.h \
-    inc/gl_scene_glass.h \
     inc/gl_scene_item.h \
+    inc/gl_scene_label_placer.h \
     inc/gl_scene_loader.h \
     inc/gl_scene_manipulator.h \
     inc/gl_scene_mesh.h \
+    inc/gl_scene_mesh_cache.h \
     inc/gl_scene_object.h \
+    inc/gl_scene_occlusion_culler.h \
+    inc/gl_scene_optimizer.h \
+    inc/gl_scene_overlay_renderer.h \
     inc/gl_scene_pipe.h \
+    inc/gl_scene_program_cache.h \
     inc/gl_scene_projection.h \
+    inc/gl_scene_quality_controller.h \
+    inc/gl_scene_resource_manager.h \
+    inc/gl_scene_streaming_texture.h \
+    inc/gl_scene_text_renderer.h \
+    inc/gl_scene_texture_cache.h \
+    inc/gl_scene_texture_manager.h \
     inc/gl_scene_types.h \
     inc/gl_scene_utility.h \
     inc/gl_scene_view.h
@@ -3,7 +3,10 @@
 #include "gl_scene_mesh.h"
 #include "gl_scene_defaults.h"
 #include "gl_scene_item.h"
+#include "gl_scene_batch.h"
 #include "gl_scene_object.h"
+#include <unordered_map>
+#include <functional>
 
 namespace gl_scene
 {
@@ -17,7 +20,9 @@ namespace gl_scene
 class Scene
 {
  public:
-    using Ptr = std::shared_ptr<Scene>;
+    using Ptr             = std::shared_ptr<Scene>;
+    using ChangedCallback = std::function<void()>;
+    using ListenerID      = uint64_t;
     /**
      * @brief Constructor for the Scene. Creates Scene with all necessary data.
      * @param meshes - the container with meshes (is necessary for visuzlization of the scene's items with static
@@ -54,32 +59,110 @@ class Scene
      */
     void update();
 
+    /**
+     * @brief Merges the visible static items into the batches (see Batch), each batch is drawn by the single call. The
+     * items sharing the pipe, the texture and the render state are merged within the chunks of the space, so the
+     * batches are still culled. The frozen item's geometry, transformation, color and visibility are baked into its
+     * batch, the item must be thawed before they're changed. The blended items, the items with the mutable geometry or
+     * the streaming texture and the strips and the fans aren't frozen. The items are appended to the built batches
+     * with the same key.
+     * @return the number of the newly frozen items
+     */
+    size_t freeze();
+
+    /**
+     * @brief Moves the frozen item back to the items drawn by their own calls. Only the item's vertices are changed in
+     * its batch, the batch is compacted once most of its items are thawed.
+     * @param item - the frozen item
+     * @return false if the item isn't frozen
+     */
+    bool thaw(const Item& item);
+
+    /**
+     * @brief Adds the text item into the scene
+     * @param item - the text item
+     * @return the handle of the added text item
+     */
+    TextItemID addTextItem(const TextItem& item);
+
+    /**
+     * @brief Replaces the text item, the item's layout is rebuilt by the next frame
+     * @param text_item_id - the handle of the text item
+     * @param item - the new text item
+     * @return false if there is no such text item
+     */
+    bool updateTextItem(TextItemID text_item_id, const TextItem& item);
+
+    /**
+     * @brief Moves the text item, the item's layout is kept
+     * @param text_item_id - the handle of the text item
+     * @param position - the new anchor position
+     * @return false if there is no such text item
+     */
+    bool moveTextItem(TextItemID text_item_id, const Vec3& position);
+
+    /**
+     * @brief Removes the text item from the scene
+     * @param text_item_id - the handle of the text item
+     * @return false if there is no such text item
+     */
+    bool removeTextItem(TextItemID text_item_id);
+
+    /**
+     * @brief Adds the callback called on each change of the scene, each view sharing the scene adds its own one
+     * @param callback - the callback
+     * @return the handle of the listener to remove it by
+     */
+    ListenerID addChangedListener(const ChangedCallback& callback);
+
+    /**
+     * @brief Removes the callback added by the addChangedListener
+     * @param listener_id - the handle of the listener
+     */
+    void removeChangedListener(ListenerID listener_id);
+
     /** setters */
-    inline void setTextItems(const gl_scene::TextItem::Pack& items) { mTextItemPack = items; }
+    void setTextItems(const gl_scene::TextItem::Pack& items);
 
     /** getters */
     inline const gl_scene::TextItem::Pack& getTextItems() const { return mTextItemPack; }
-    inline const VertexPack& getVertices() const { return mVertices; }
+    inline const std::vector<uint64_t>& getTextItemRevisions() const { return mTextItemRevisions; }
+    inline const BufferSegments& getVertexSegments() const { return mVertexSegments; }
+    inline const BufferSegments& getIndexSegments() const { return mIndexSegments; }
     inline const Shader::Map& getShaders() const { return mShaderMap; }
     inline const Item::PtrMap& getItems() const { return mItemPtrMap; }
     inline const Light& getLight() const { return mLight; }
+    inline const TexturesMap& getTextures() const { return mTexturesMap; }
+    inline const Batch::Pack& getBatches() const { return mBatches; }
+    const Batch::Location* findFrozen(const Item& item) const;  // null if the item isn't frozen
     GeometryData getGeometryData(MeshID mesh_id) const;
-    Texture::Ptr getTexture(TextureID texture_id);
 
  protected:
     SceneObject::PtrPack mObjectPtrPack;
 
  private:
     void initialize();
+    void notifyChanged();
 
     const Mesh::Map& mMeshMap;
     Light mLight;
     const Shader::Map& mShaderMap;
-    VertexPack mVertices;
+    BufferSegments mVertexSegments;
+    BufferSegments mIndexSegments;
     Mesh::GeometryMap mMeshGeometryMap;
     Item::PtrMap mItemPtrMap;
     TextItem::Pack mTextItemPack;
+    std::vector<uint64_t> mTextItemRevisions;
+    std::vector<TextItemID> mTextItemIds;
+    std::unordered_map<TextItemID, size_t> mTextItemIndexes;
+    TextItemID mNextTextItemId{0};
+    uint64_t mTextItemRevision{0};
+    std::vector<std::pair<ListenerID, ChangedCallback>> mChangedListeners;
+    ListenerID mNextListenerId{0};
     TexturesMap mTexturesMap;
+    Batch::Pack mBatches;
+    std::unordered_map<const Item*, Batch::Location> mFrozenItems;
+    uint64_t mBatchRevision{0};
 };
 
 }  // namespace gl_scene
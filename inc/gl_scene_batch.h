@@ -0,0 +1,76 @@
+#pragma once
+
+#include "gl_scene_item.h"
+
+namespace gl_scene
+{
+
+/**
+ * The Batch Struct
+ * @brief The merged geometry of the frozen items (see Scene::freeze) sharing the pipe, the texture, the render state
+ * and the spatial chunk. The items' vertices are transformed into the world coordinates and carry the items' colors
+ * and ID colors, so the batch is drawn by the single call and is culled by its bounds. The thawed item's vertices are
+ * collapsed into the point, the batch is compacted once most of its items are thawed, and the items frozen later with
+ * the same key are appended to it.
+ */
+struct Batch
+{
+    using Pack       = std::vector<Batch>;
+    using Vertex     = std::array<float, 16>;  // the item's vertex (see gl_scene::Vertex), the color and the ID color
+    using VertexPack = std::vector<Vertex>;
+
+    // the item's vertices within the batch
+    struct Slot
+    {
+        const Item* item;  // nullptr once the item is thawed
+        GLint first;
+        GLsizei count;
+        uint64_t revision;  // the scene's revision the slot was frozen or thawed at
+    };
+
+    // the frozen item's place in the scene's batches
+    struct Location
+    {
+        size_t batch;
+        size_t slot;
+    };
+
+    /**
+     * @brief Appends the item's primitives, the indexed ones are unrolled
+     * @param item - the frozen item
+     * @param item_vertices - the item's vertices in the local coordinates
+     * @param indices - the item's indices (could be nullptr if the geometry is not indexed)
+     * @param count - the number of the indices or of the vertices if the geometry is not indexed
+     * @param freeze_revision - the scene's revision of the freeze
+     */
+    void append(const Item& item, const gl_scene::Vertex* item_vertices, const GLuint* indices, size_t count,
+                uint64_t freeze_revision);
+
+    /**
+     * @brief Collapses the slot's vertices, so its primitives have no area and draw nothing
+     * @param slot - the slot's index
+     * @param thaw_revision - the scene's revision of the thaw
+     */
+    void collapse(size_t slot, uint64_t thaw_revision);
+
+    /**
+     * @brief Removes the thawed slots and their vertices, the bounds are recalculated
+     * @param compact_revision - the scene's revision of the compaction
+     */
+    void compact(uint64_t compact_revision);
+
+    PipeID pipeId;
+    TextureID textureId;
+    RenderParameters renderParameters;  // the mode and the attributes, the frozen items are opaque
+    bool isPickable;                    // the items have the IDs, only such batches are drawn by the picking
+    std::array<int, 3> chunk;           // the chunk of the space (see defaults::batches::kChunkSize)
+    VertexPack vertices;
+    std::vector<Slot> slots;
+    size_t frozenCount{0};       // the slots not thawed yet
+    uint64_t revision{0};        // the latest revision of the slots
+    uint64_t layoutRevision{0};  // the latest revision the vertices were appended or compacted at
+    Vec3 min;                    // the bounds in the world coordinates
+    Vec3 max;
+};
+
+}  // namespace gl_scene
@@ -2,6 +2,7 @@
 
 #include "gl_scene_types.h"
 #include "gl_scene_projection.h"
+#include "gl_scene_camera_state.h"
 
 namespace gl_scene
 {
@@ -15,6 +16,8 @@ class Camera : public QObject
     Q_OBJECT
 
  public:
+    using Ptr = std::shared_ptr<Camera>;
+
     enum class MovementDirection
     {
         kForward,
@@ -207,6 +210,33 @@ class Camera : public QObject
      */
     gl_scene::Vec2 toScreenCoordinates(const gl_scene::Vec3& world_point) const;
 
+    /**
+     * @brief Projects the screen's points to the OXY plane
+     * @param screen_points - the contiguous x, y pairs of the screen's points
+     * @param count - the number of the points
+     * @param world_points - the contiguous x, y, z triples of the points in world coordinates
+     * @param world_z - the z coordinate of the OXY plane
+     */
+    void toWorldXYCoordinates(const float* screen_points, size_t count, float* world_points,
+                              float world_z = 0.0f) const;
+
+    /**
+     * @brief Projects the screen's points to the camera plane
+     * @param screen_points - the contiguous x, y pairs of the screen's points
+     * @param count - the number of the points
+     * @param world_points - the contiguous x, y, z triples of the points in world coordinates
+     * @param distance - the relative value of camera plane (0 coresponds to near plane, 1 coresponds to far plane)
+     */
+    void toWorldCoordinates(const float* screen_points, size_t count, float* world_points, float distance) const;
+
+    /**
+     * @brief Projects the world's points to the screen
+     * @param world_points - the contiguous x, y, z triples of the world's points
+     * @param count - the number of the points
+     * @param screen_points - the contiguous x, y pairs of the screen's points (in pixels, y goes down)
+     */
+    void toScreenPixels(const float* world_points, size_t count, float* screen_points) const;
+
     /** setters */
     void resetTo(const Camera& camera);
     void setPitch(float pitch);
@@ -222,7 +252,9 @@ class Camera : public QObject
     void setOrtho(const ProjectionOrtho& ortho);
 
     /** getters */
-    inline Mat4 getTransformation() const { return getProjection() * getView(); }
+    inline const Mat4& getTransformation() const { return mState.transformation; }
+    inline const Mat4& getInverseTransformation() const { return mState.inverseTransformation; }
+    inline const CameraState& getState() const { return mState; }
     inline const Mat4& getView() const { return mViewMatrix; }
     inline const Mat4& getProjection() const { return mCurrentProjection->get(); }
     inline float getYaw() const { return mYaw; }
@@ -247,6 +279,7 @@ class Camera : public QObject
  private:
     void update(bool use_angles = true, bool update_look = false);
     void calculateViewMatrix();
+    void calculateState();
     void checkRangeLimits();
 
     float mYaw;
@@ -270,6 +303,7 @@ class Camera : public QObject
     ProjectionOrtho mProjectionOrtho;
     Projection* mCurrentProjection;
     Mat4 mViewMatrix;
+    CameraState mState;
 };
 
 }  // namespace gl_scene
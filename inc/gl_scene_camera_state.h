@@ -0,0 +1,80 @@
+#pragma once
+
+#include "gl_scene_types.h"
+#include <QVector4D>
+
+namespace gl_scene
+{
+
+/**
+ * The CameraState Struct
+ * @brief The plain snapshot of the camera's matrices, frustum and viewport. The Camera produces it on each change, the
+ * copies could be used from any thread (e.g. for the culling and the projection in parallel) without the Camera.
+ */
+struct CameraState
+{
+    using Planes = std::array<QVector4D, 6>;
+
+    /**
+     * @brief Builds the state by the camera's matrices
+     * @param view - the view matrix
+     * @param projection - the projection matrix
+     * @param position - the camera's position
+     * @param viewport - the viewport size in the screen coordinates
+     * @return the camera state
+     */
+    static CameraState make(const Mat4& view, const Mat4& projection, const Vec3& position, const QSize& viewport);
+
+    /**
+     * @brief Projects the screen's points to the camera plane
+     * @param screen_points - the contiguous x, y pairs of the screen's points
+     * @param count - the number of the points
+     * @param world_points - the contiguous x, y, z triples of the points in world coordinates
+     * @param distance - the relative value of camera plane (0 coresponds to near plane, 1 coresponds to far plane)
+     */
+    void toWorldCoordinates(const float* screen_points, size_t count, float* world_points, float distance) const;
+
+    /**
+     * @brief Projects the screen's points to the OXY plane
+     * @param screen_points - the contiguous x, y pairs of the screen's points
+     * @param count - the number of the points
+     * @param world_points - the contiguous x, y, z triples of the points in world coordinates
+     * @param world_z - the z coordinate of the OXY plane
+     */
+    void toWorldXYCoordinates(const float* screen_points, size_t count, float* world_points,
+                              float world_z = 0.0f) const;
+
+    /**
+     * @brief Projects the world's points to the screen
+     * @param world_points - the contiguous x, y, z triples of the world's points
+     * @param count - the number of the points
+     * @param screen_points - the contiguous x, y pairs of the screen's points (in pixels, y goes down)
+     */
+    void toScreenPixels(const float* world_points, size_t count, float* screen_points) const;
+
+    /**
+     * @brief Checks the sphere against the frustum
+     * @param center - the sphere's center
+     * @param radius - the sphere's radius
+     * @return false if the sphere is entirely outside the frustum
+     */
+    bool isVisible(const Vec3& center, float radius) const;
+
+    /**
+     * @brief Checks the axis aligned box against the frustum
+     * @param min - the box's minimal corner
+     * @param max - the box's maximal corner
+     * @return false if the box is entirely outside the frustum
+     */
+    bool isVisible(const Vec3& min, const Vec3& max) const;
+
+    Mat4 view;
+    Mat4 projection;
+    Mat4 transformation;  // projection * view
+    Mat4 inverseTransformation;
+    Planes frustum;  // left, right, bottom, top, near, far, the normals look inside
+    Vec3 position;
+    QSize viewport;
+};
+
+}  // namespace gl_scene
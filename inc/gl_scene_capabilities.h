@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QOpenGLContext>
+#include <string>
+
+namespace gl_scene
+{
+
+/**
+ * The Capabilities Struct
+ * @brief The features of the OpenGL context detected in runtime. The renderer chooses its paths by them, the shaders
+ * get the GLSL version header of the context.
+ */
+struct Capabilities
+{
+    // the render paths from the slowest one
+    enum class Tier
+    {
+        kLegacy,  // OpenGL 3.0 - 3.2 (or ES 3.0), the draws are issued one by one
+        kCore,    // OpenGL 3.3+ without the indirect draws, the instancing and the timer queries
+        kModern   // OpenGL 4.3+, the multi-draw indirect and the compute shaders
+    };
+
+    // the paths the renderer has chosen by the capabilities and by the programs it has built
+    struct RenderPaths
+    {
+        bool isChosen{false};          // the paths aren't known until the renderer is initialized
+        bool isIndirect{false};        // the static items are drawn by the multi-draw indirect
+        bool isGpuCulling{false};      // the indirect draws could be culled by the compute pass
+        bool isBaseVertex{false};      // the indexed draws take the base vertex, otherwise the attributes are shifted
+        bool isIndirectLinked{false};  // the SCENE_INDIRECT programs (the indirect draws and the batches) are linked
+    };
+
+    /**
+     * @brief Detects the capabilities of the current context
+     * @return the capabilities (the default ones if there is no current context)
+     */
+    static Capabilities detect();
+
+    /**
+     * @brief Prepends the context's GLSL version header to the shader source. The source having its own version
+     * header keeps it.
+     * @param source - the shader source code without the version header
+     * @param defines - the preprocessor definitions placed after the version header (e.g. "#define NAME\n")
+     * @return the shader source code
+     */
+    std::string toShaderSource(const std::string& source, const std::string& defines = {}) const;
+
+    /**
+     * @brief Describes the capabilities for the diagnostics (e.g. "OpenGL 4.6, modern (multi-draw indirect, ...):
+     * instancing, compute, ...")
+     * @return the description
+     */
+    QString toString() const;
+
+    /**
+     * @brief Records the paths chosen by the renderer, the tier is lowered to the one they actually give
+     * @param paths - the chosen paths
+     */
+    void choosePaths(const RenderPaths& paths);
+
+    /** getters */
+    inline bool isSupported() const { return majorVersion >= 3; }  // the shaders need OpenGL 3.0 (or ES 3.0) at least
+
+    int majorVersion{3};
+    int minorVersion{3};
+    bool isES{false};
+    bool isBaseVertex{false};
+    bool isInstancing{false};
+    bool isMultiDrawIndirect{false};
+    bool isIndirectCount{false};  // the draw count of the multi-draw indirect is read from the buffer
+    bool isBufferStorage{false};
+    bool isUniformBuffer{false};
+    bool isCompute{false};
+    bool isTimerQuery{false};
+    bool isProgramBinary{false};
+    bool isParallelCompile{false};
+    Tier tier{Tier::kCore};  // the tier of the detected features, then of the chosen paths (see choosePaths)
+    RenderPaths paths;
+};
+
+}  // namespace gl_scene
@@ -3,6 +3,7 @@
 #include "gl_scene_types.h"
 #include "gl_scene_camera.h"
 #include "gl_scene_mesh.h"
+#include "gl_scene_pipe.h"
 
 namespace gl_scene
 {
@@ -74,10 +75,17 @@ extern const PipeID k3DTexturedLast;
 extern const PipeID k2DTexturedLast;
 }  // namespace id
 
+extern const Pipe::Attributes kAttributes;
+extern const Pipe::Attributes kTextAttributes;
+extern const Pipe::Attributes kOverlayAttributes;
 }  // namespace pipes
 
 namespace shaders
 {
+extern const std::string kCulling;
+extern const Shader kText;
+extern const Shader kOverlay;
+extern const Shader kDepthReduction;
 extern const Shader::Map kDefault;
 }  // namespace shaders
 
@@ -90,9 +98,24 @@ namespace id
 extern const TextureID kCommon;
 }  // namespace id
 
+extern const qint64 kUploadBudget;
+extern const uint kAtlasUnit;
+
 extern const TexturesMap kDefault;
 }  // namespace textures
 
+namespace quality
+{
+extern const float kTargetFrameTime;
+extern const QualityLevel::Pack kLevels;
+}  // namespace quality
+
+namespace batches
+{
+extern const float kChunkSize;
+extern const float kMinFrozenShare;
+}  // namespace batches
+
 }  // namespace defaults
 
 }  // namespace gl_scene
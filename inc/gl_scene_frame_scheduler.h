@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QtGlobal>
+#include <functional>
+
+namespace gl_scene
+{
+
+/**
+ * The FrameScheduler Class
+ * @brief The class decides when the view renders the frame. The invalidations are collected until the frame starts, so
+ * any number of them costs the single frame. The next frame isn't requested until the previous one is swapped, so the
+ * view renders at most once per vsync, and the frames aren't requested at all while nothing changes. The continuous
+ * rendering is kept only while there are active animations.
+ */
+class FrameScheduler
+{
+ public:
+    using RequestCallback = std::function<void()>;
+
+    enum Reason : uint
+    {
+        kCamera    = 1 << 0,
+        kScene     = 1 << 1,
+        kOverlay   = 1 << 2,
+        kSelection = 1 << 3,
+        kResources = 1 << 4,
+        kAnimation = 1 << 5,
+        kOcclusion = 1 << 6,  // the occlusion culler waits for the depth capture
+        kDepthMap  = 1 << 7   // the labels wait for the depth map
+    };
+
+    /**
+     * @brief Constructor for the FrameScheduler
+     * @param callback - the callback requesting the frame from the view (e.g. QOpenGLWidget::update)
+     */
+    explicit FrameScheduler(const RequestCallback& callback);
+
+    /**
+     * @brief Marks the view as changed, the frame is requested unless it's requested or being rendered already
+     * @param reasons - the combination of the Reason flags
+     */
+    void invalidate(uint reasons);
+
+    /**
+     * @brief Must be called at the frame's start
+     * @return the reasons collected since the previous frame, 0 if the frame is forced by the window system
+     */
+    uint beginFrame();
+
+    /**
+     * @brief Must be called when the frame is presented (e.g. on QOpenGLWidget::frameSwapped) or when it's known that
+     * it won't be presented
+     */
+    void endFrame();
+
+    /**
+     * @brief Starts the animation, the frames are rendered continuously until all animations are stopped
+     */
+    void startAnimation();
+
+    /**
+     * @brief Stops the animation started by the startAnimation
+     */
+    void stopAnimation();
+
+    /** getters */
+    inline bool isAnimating() const { return mAnimationCount > 0; }
+
+ private:
+    void request();
+
+    RequestCallback mCallback;
+    uint mReasons{0};
+    int mAnimationCount{0};
+    bool mIsRequested{false};
+    bool mIsInFlight{false};
+};
+
+}  // namespace gl_scene
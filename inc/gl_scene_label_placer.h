@@ -0,0 +1,63 @@
+#pragma once
+
+#include "gl_scene_types.h"
+#include <functional>
+
+namespace gl_scene
+{
+
+/**
+ * The LabelPlacer Class
+ * @brief The class selects the text items to be rendered in the frame. The anchors are projected in bulk, the
+ * off-screen and occluded (optionally, against the depth buffer) labels are rejected and the overlapping ones are
+ * resolved by the screen-space occupancy grid in favor of the higher priority.
+ */
+class LabelPlacer
+{
+ public:
+    using BoundsGetter = std::function<QRect(size_t index)>;
+
+    struct Label
+    {
+        using Pack = std::vector<Label>;
+        const TextItem* item;
+        size_t index;   // the item's index in the container
+        QPoint origin;  // the baseline origin in the logical pixels
+    };
+
+    struct DepthMap
+    {
+        QSize size;                // in the device pixels
+        std::vector<float> depth;  // the window depth values, the rows go bottom up
+    };
+
+    /**
+     * @brief Places the text items
+     * @param items - the container with the text items
+     * @param transformation - the camera's transformation (projection * view)
+     * @param size - the viewport size in the logical pixels
+     * @param bounds_getter - returns the text bounds of the item by its index (relative to the baseline origin in the
+     * logical pixels)
+     * @param depth_map - the depth buffer the anchors are tested against, nullptr if the occlusion is not tested
+     * @return the labels to be rendered
+     */
+    const Label::Pack& place(const TextItem::Pack& items, const Mat4& transformation, const QSize& size,
+                             const BoundsGetter& bounds_getter, const DepthMap* depth_map = nullptr);
+
+ private:
+    struct Anchor
+    {
+        const TextItem* item;
+        size_t index;
+        QPoint origin;
+    };
+
+    bool occupy(const QRect& rect);
+
+    std::vector<Anchor> mAnchors;
+    std::vector<uint8_t> mGrid;
+    QSize mGridSize;
+    Label::Pack mLabels;
+};
+
+}  // namespace gl_scene
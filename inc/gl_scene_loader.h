@@ -1,6 +1,7 @@
 #pragma once
 
-#include "gl_scene_types.h"
+#include "gl_scene_mesh.h"
+#include <QFuture>
 
 #define LOAD ModelLoader::load
 
@@ -23,7 +24,60 @@ class ModelLoader
      */
     static VertexPack load(const std::string& filename);
 
+    /**
+     * @brief Loads the indexed mesh from the file. The unique vertices are kept once and referred by the index buffer.
+     * The triangles are reordered for the post-transform vertex cache and the vertices for the vertex fetch locality.
+     * @param filename - the 3D model file name
+     * @return the indexed mesh (the mesh is empty if the file can't be loaded)
+     */
+    static Mesh loadIndexed(const std::string& filename);
+
+    /**
+     * @brief Loads the indexed mesh through the binary mesh cache. The cache container is looked up by the content
+     * hash of the file (see gl_scene::cacheFilename). If it exists, it is memory mapped and the mesh refers the mapped
+     * data directly. Otherwise the file is loaded by loadIndexed and the container is written for the next runs
+     * together with the LOD chain built by MeshOptimizer::simplify. The returned mesh draws the full detail LOD.
+     * @param filename - the 3D model file name
+     * @param cache_dir - the cache directory (if empty the container is placed next to the model file)
+     * @return the indexed mesh (the mesh is empty if the file can't be loaded)
+     */
+    static Mesh loadCached(const std::string& filename, const std::string& cache_dir = {});
+
+    /**
+     * @brief Loads the mesh from the file on the worker thread (see load)
+     * @param filename - the 3D model file name
+     * @return the future with the container with vertices
+     */
+    static QFuture<VertexPack> loadAsync(const std::string& filename);
+
+    /**
+     * @brief Loads the indexed mesh through the binary mesh cache on the worker thread (see loadCached). Only the
+     * file reading, the parsing and the cache writing leave the caller's thread. The mesh isn't uploaded and nothing is
+     * drawn in its place, the caller adds the finished mesh to the mesh map the scene is built from. The static
+     * geometry of all scene's meshes shares the buffers built once per context group (see ResourceManager), so the
+     * meshes aren't added to them on the fly. The placeholders and the budgeted upload are done for the textures only
+     * (see TextureManager).
+     * @param filename - the 3D model file name
+     * @param cache_dir - the cache directory (if empty the container is placed next to the model file)
+     * @return the future with the indexed mesh
+     */
+    static QFuture<Mesh> loadCachedAsync(const std::string& filename, const std::string& cache_dir = {});
+
  private:
+    /**
+     * @brief Loads the Wavefront OBJ file. The file is memory mapped and split into newline aligned chunks which are
+     * parsed in parallel. Faces could be given in "v", "v/vt", "v//vn" or "v/vt/vn" form and could have any amount of
+     * corners (polygons are triangulated as a fan). Relative (negative) indices are supported.
+     * @param filename - the 3D model file name
+     * @return the container with vertices. If face has no normals the flat normal of the triangle is used.
+     */
     static VertexPack loadObj(const std::string& filename);
+
+    /**
+     * @brief Loads the Wavefront OBJ file as the indexed mesh. Vertices without normals get the smooth normals.
+     * @param filename - the 3D model file name
+     * @return the indexed mesh
+     */
+    static Mesh loadObjIndexed(const std::string& filename);
 };
 }  // namespace gl_scene
@@ -15,12 +15,36 @@ class Mesh
  public:
     using Map         = std::map<MeshID, Mesh>;
     using GeometryMap = std::map<MeshID, GeometryData>;
+
+    /**
+     * @brief Constructor for the empty Mesh
+     */
+    Mesh() = default;
+
     /**
      * @brief Constructor for Mesh
      * @param vertices - the container with model vertices
      */
     explicit Mesh(const VertexPack& vertex_pack);
 
+    /**
+     * @brief Constructor for the indexed Mesh
+     * @param vertex_pack - the container with model vertices
+     * @param index_pack - the container with triangles' indices of the model vertices
+     */
+    Mesh(const VertexPack& vertex_pack, const IndexPack& index_pack);
+
+    /**
+     * @brief Constructor for the Mesh which refers the external data (e.g. the memory mapped mesh container)
+     * @param storage - the owner of the data. It is kept alive while the mesh exists.
+     * @param vertex_data - the pointer to the vertices
+     * @param vertex_count - the amount of vertices
+     * @param index_data - the pointer to the indices (could be nullptr if the mesh is not indexed)
+     * @param index_count - the amount of indices
+     */
+    Mesh(const std::shared_ptr<const void>& storage, const Vertex* vertex_data, size_t vertex_count,
+         const GLuint* index_data, size_t index_count);
+
     /**
      * @brief Constructor for Mesh
      * @param point_pack - the container with model points
@@ -48,7 +72,13 @@ class Mesh
 
     /** getters */
     inline const VertexPack& getVertices() const { return mVertexPack; }
+    inline const IndexPack& getIndices() const { return mIndexPack; }
     inline const Point3Pack& getPoints() const { return mPointPack; }
+    inline const Vertex* getVertexData() const { return mStorage ? mVertexData : mVertexPack.data(); }
+    inline const GLuint* getIndexData() const { return mStorage ? mIndexData : mIndexPack.data(); }
+    inline size_t getVertexCount() const { return mStorage ? mVertexCount : mVertexPack.size(); }
+    inline size_t getIndexCount() const { return mStorage ? mIndexCount : mIndexPack.size(); }
+    inline bool isIndexed() const { return getIndexCount() > 0; }
 
  private:
     void levelPoints(float z);
@@ -57,6 +87,12 @@ class Mesh
 
     Point3Pack mPointPack;
     VertexPack mVertexPack;
+    IndexPack mIndexPack;
+    std::shared_ptr<const void> mStorage;
+    const Vertex* mVertexData{nullptr};
+    const GLuint* mIndexData{nullptr};
+    size_t mVertexCount{0};
+    size_t mIndexCount{0};
 };
 
 }  // namespace gl_scene
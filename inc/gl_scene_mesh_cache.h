@@ -0,0 +1,92 @@
+#pragma once
+
+#include "gl_scene_mesh.h"
+#include "gl_scene_pipe.h"
+#include <QFile>
+
+namespace gl_scene
+{
+
+/**
+ * The MeshCache Class
+ * @brief The class represents the binary mesh container mapped into memory.
+ * The container consists of the header (version, vertex layout descriptor, bounds), the LODs table and the index and
+ * vertex blobs. The blobs are used for rendering directly from the mapped memory without any parsing or copying.
+ */
+class MeshCache
+{
+ public:
+    using Ptr = std::shared_ptr<MeshCache>;
+
+    static const uint32_t kVersion;
+
+    struct Lod
+    {
+        GLuint indexFirst;
+        GLuint indexCount;
+        float error;
+    };
+    using LodPack = std::vector<Lod>;
+
+    struct Bounds
+    {
+        Point3 min;
+        Point3 max;
+    };
+
+    /**
+     * @brief Maps the mesh container file into memory
+     * @param filename - the container's file name
+     * @return shared pointer to the mapped container or nullptr if the file is absent, has wrong format or version
+     */
+    static Ptr open(const QString& filename);
+
+    /**
+     * @brief Writes the mesh into the container file
+     * @param filename - the container's file name
+     * @param mesh - the mesh to store
+     * @param lods - the container with the mesh's LODs, the first is the full detail one and every LOD refers its range
+     * of the mesh's indices (if empty the whole mesh is stored as the single LOD)
+     * @return true if the container has been written
+     */
+    static bool write(const QString& filename, const Mesh& mesh, const LodPack& lods = {});
+
+    /**
+     * @brief Builds the container's file name by the content hash of the source file
+     * @param source_filename - the source model's file name
+     * @param cache_dir - the cache directory (if empty the container is placed next to the source file)
+     * @return the container's file name or empty string if the source file can't be read
+     */
+    static QString cacheFilename(const QString& source_filename, const QString& cache_dir = {});
+
+    /**
+     * @brief Creates the mesh which refers the mapped data. The mapping stays alive while the mesh exists. The mesh
+     * draws the first LOD, the coarser ones follow it in the index blob (see getLods).
+     * @param cache - shared pointer to the mapped container
+     * @return the mesh
+     */
+    static Mesh toMesh(const Ptr& cache);
+
+    /** getters */
+    inline const Vertex* getVertices() const { return mVertices; }
+    inline const GLuint* getIndices() const { return mIndices; }
+    inline size_t getVertexCount() const { return mVertexCount; }
+    inline size_t getIndexCount() const { return mIndexCount; }
+    inline const Bounds& getBounds() const { return mBounds; }
+    inline const LodPack& getLods() const { return mLods; }
+    inline const Pipe::Attributes& getAttributes() const { return mAttributes; }
+
+ private:
+    MeshCache() = default;
+
+    QFile mFile;
+    const Vertex* mVertices{nullptr};
+    const GLuint* mIndices{nullptr};
+    size_t mVertexCount{0};
+    size_t mIndexCount{0};
+    Bounds mBounds;
+    LodPack mLods;
+    Pipe::Attributes mAttributes;
+};
+
+}  // namespace gl_scene
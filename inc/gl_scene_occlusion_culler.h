@@ -0,0 +1,92 @@
+#pragma once
+
+#include "gl_scene_camera_state.h"
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLBuffer>
+
+namespace gl_scene
+{
+
+/**
+ * The OcclusionCuller Class
+ * @brief The class rejects the items hidden behind the others by the hierarchical depth (the pyramid of the farthest
+ * depths) of the previous frame. The frame's depth is reduced by the GPU to the farthest depth of each 4x4 tile (the
+ * pyramid's base level), the base level is read back into the pixel pack buffer without waiting for it and is taken by
+ * one of the next frames once the GPU has written it. The rest of the levels are built from the base one. The item's
+ * bounds are projected by the camera state of the captured frame and tested against the pyramid level where they
+ * cover at most 2x2 texels, so the test costs the same for any item's size. The items appearing from behind the
+ * occluders are drawn one frame late. The culling is off on the OpenGL ES, the float targets aren't read back there.
+ */
+class OcclusionCuller
+{
+ public:
+    using Ptr = std::shared_ptr<OcclusionCuller>;
+
+    /**
+     * @brief Starts reading the frame's depth back, it's skipped while the previous capture isn't taken yet. Must be
+     * called with the current OpenGL context, the framebuffer bound is changed.
+     * @param framebuffer - the framebuffer with the frame's depth, it could be multisampled
+     * @param buffer_size - the framebuffer's size
+     * @param viewport - the area of the camera's viewport in the framebuffer (in pixels, y goes up)
+     * @param state - the camera state the frame is rendered with
+     */
+    void capture(GLuint framebuffer, const QSize& buffer_size, const QRect& viewport, const CameraState& state);
+
+    /**
+     * @brief Rebuilds the pyramid by the captured depth if the GPU has written it. Must be called with the current
+     * OpenGL context.
+     */
+    void update();
+
+    /**
+     * @brief Forgets the captured depth, nothing is occluded until the next capture is taken
+     */
+    void reset();
+
+    /**
+     * @brief Destroys the OpenGL resources of the culler. Must be called with the current OpenGL context.
+     */
+    void destroy();
+
+    /**
+     * @brief Checks the axis aligned box against the depth pyramid
+     * @param min - the box's minimal corner in the world coordinates
+     * @param max - the box's maximal corner in the world coordinates
+     * @return true if the box is entirely behind the captured depth
+     */
+    bool isOccluded(const Vec3& min, const Vec3& max) const;
+
+    /** getters */
+    inline bool isCapturing() const { return mFence != nullptr; }  // the capture isn't taken by the update yet
+
+ private:
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<float> depth;  // the farthest depth of the texel, the rows go bottom up
+    };
+
+    bool prepare(const QSize& buffer_size, const QSize& base_size);
+
+    std::shared_ptr<QOpenGLShaderProgram> mProgram;  // defaults::shaders::kDepthReduction
+    QOpenGLVertexArrayObject mVao;
+    GLuint mDepthTexture{0};  // the frame's depth resolved to be sampled
+    GLuint mDepthFramebuffer{0};
+    QSize mDepthSize;
+    GLuint mBaseTexture{0};  // the pyramid's base level reduced by the GPU
+    GLuint mBaseFramebuffer{0};
+    QSize mBaseSize;
+    bool mIsSupported{true};
+    QOpenGLBuffer mBuffer{QOpenGLBuffer::PixelPackBuffer};
+    GLsync mFence{nullptr};
+    bool mIsStale{false};  // the pending capture is dropped by the reset
+    QSize mCaptureSize;
+    CameraState mCaptureState;
+    CameraState mState;
+    std::vector<Level> mLevels;
+};
+
+}  // namespace gl_scene
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "gl_scene_types.h"
+
+namespace gl_scene
+{
+
+/**
+ * The MeshOptimizer Class
+ * @brief The class provides functionality to reorder the indexed geometry for faster rendering
+ */
+class MeshOptimizer
+{
+ public:
+    /**
+     * @brief Reorders the triangles for the post-transform vertex cache locality (Forsyth's linear-speed algorithm)
+     * @param indices - the container with triangles' indices
+     * @param vertex_count - the amount of vertices the indices refer to
+     */
+    static void optimizeVertexCache(IndexPack& indices, size_t vertex_count);
+
+    /**
+     * @brief Reorders the vertices in order of their first usage by the triangles (for the vertex fetch locality). The
+     * indices are remapped accordingly, unused vertices are removed.
+     * @param vertices - the container with vertices
+     * @param indices - the container with triangles' indices
+     */
+    static void optimizeVertexFetch(VertexPack& vertices, IndexPack& indices);
+
+    /**
+     * @brief Simplifies the triangles by the vertex clustering. The vertices within the same cell of the uniform grid
+     * are merged into the first of them, the collapsed triangles are removed. The vertices aren't changed, so the
+     * simplified indices refer the same vertex container.
+     * @param vertices - the container with vertices
+     * @param indices - the container with triangles' indices
+     * @param cell_size - the size of the grid's cell
+     * @return the container with the simplified triangles' indices
+     */
+    static IndexPack simplify(const VertexPack& vertices, const IndexPack& indices, float cell_size);
+};
+
+}  // namespace gl_scene
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "gl_scene_pipe.h"
+
+namespace gl_scene
+{
+
+/**
+ * The OverlayRenderer Class
+ * @brief The class renders the 2D primitives (e.g. the selection frame) over the scene as the final pass of the
+ * frame. The primitives are collected during the frame and rendered as the triangles by the single draw call.
+ */
+class OverlayRenderer
+{
+ public:
+    using Ptr = std::shared_ptr<OverlayRenderer>;
+
+    /**
+     * @brief Constructor for the OverlayRenderer. Must be called with the current OpenGL context.
+     */
+    OverlayRenderer();
+
+    /**
+     * @brief Adds the line segment
+     * @param p1 - the first point in the logical pixels
+     * @param p2 - the second point in the logical pixels
+     * @param color - the line color
+     * @param width - the line width in the logical pixels
+     */
+    void addLine(const QPointF& p1, const QPointF& p2, const Color& color, float width = 1.0f);
+
+    /**
+     * @brief Adds the rectangle's outline. The outline covers the edge pixels of the rectangle.
+     * @param rect - the rectangle in the logical pixels
+     * @param color - the outline color
+     * @param width - the outline width in the logical pixels
+     */
+    void addFrame(const QRectF& rect, const Color& color, float width = 1.0f);
+
+    /**
+     * @brief Adds the filled rectangle
+     * @param rect - the rectangle in the logical pixels
+     * @param color - the fill color
+     */
+    void addRect(const QRectF& rect, const Color& color);
+
+    /**
+     * @brief Renders the added primitives and clears them. Must be called with the current OpenGL context.
+     * @param size - the viewport size in the logical pixels
+     */
+    void render(const QSize& size);
+
+ private:
+    using OverlayVertex = std::array<float, 6>;
+
+    void addQuad(const QPointF& p1, const QPointF& p2, const QPointF& p3, const QPointF& p4, const Color& color);
+
+    ScreenPipe::Ptr mPipe;
+    std::vector<OverlayVertex> mVertices;
+};
+
+}  // namespace gl_scene
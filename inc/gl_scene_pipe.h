@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gl_scene_types.h"
+#include "gl_scene_camera_state.h"
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions>
@@ -9,6 +10,9 @@
 
 namespace gl_scene
 {
+
+struct Batch;
+
 /**
  * The Pipe Class
  * @brief The class is a wrapper on the low level OpenGL structures (such as buffers and shader programs).
@@ -26,19 +30,58 @@ class Pipe : public QOpenGLFunctions
     };
     using Attributes = std::vector<Attribute>;
 
+    // the objects which could be shared by the pipes of the contexts within the share group (unlike the VAO)
+    struct Resources
+    {
+        std::shared_ptr<QOpenGLShaderProgram> program;
+        std::shared_ptr<QOpenGLBuffer> vbo;  // the pipe creates its own buffer if it's null
+        std::shared_ptr<QOpenGLBuffer> ibo;
+    };
+
+    /**
+     * @brief Compiles the shader program. Must be called with the current OpenGL context.
+     * @param shader - the structure with the source code for the shader processors of the video adapter pipeline
+     * @return the linked program
+     */
+    static std::shared_ptr<QOpenGLShaderProgram> makeProgram(const Shader& shader);
+
+    /**
+     * @brief Uploads the buffers. Must be called with the current OpenGL context.
+     * @param vertex_segments - the container with the vertex data segments
+     * @param index_segments - the container with the index data segments (the index buffer is null if it's empty)
+     * @return the resources without the program
+     */
+    static Resources makeBuffers(const BufferSegments& vertex_segments, const BufferSegments& index_segments = {});
+
     /**
      * @brief Constructor for the Pipe
      * @param shader - the structure with the source code for the shader processors of the video adapter pipeline
      * @param data - the pointer to a data
      * @param count - the data size in bytes
      * @param attributes - the container with the attributes' data
+     * @param index_data - the pointer to an index data (could be nullptr if geometry is not indexed)
+     * @param index_count - the index data size in bytes
+     */
+    Pipe(const Shader& shader, const void* data, int count, const Pipe::Attributes& attributes,
+         const void* index_data = nullptr, int index_count = 0);
+
+    /**
+     * @brief Constructor for the Pipe
+     * @param shader - the structure with the source code for the shader processors of the video adapter pipeline
+     * @param vertex_segments - the container with the vertex data segments. The segments are uploaded one by one
+     * into the single vertex buffer.
+     * @param attributes - the container with the attributes' data
+     * @param index_segments - the container with the index data segments
      */
-    Pipe(const Shader& shader, const void* data, int count, const Pipe::Attributes& attributes);
+    Pipe(const Shader& shader, const BufferSegments& vertex_segments, const Pipe::Attributes& attributes,
+         const BufferSegments& index_segments = {});
 
     /**
-     * @brief Creates all necessary data of the Pipe
+     * @brief Constructor for the Pipe
+     * @param resources - the shared program and buffers, only the VAO is created by the pipe
+     * @param attributes - the container with the attributes' data
      */
-    void create();
+    Pipe(const Resources& resources, const Pipe::Attributes& attributes);
 
     /**
      * @brief Binds the pipe to the OpenGL pipeline (and makes it the current one). The Pipe's program, VAO and VBO will
@@ -60,10 +103,24 @@ class Pipe : public QOpenGLFunctions
     void allocate(const void* data, int count);
 
     /**
-     * @brief Loads shader program from the source code
-     * @param shader - the structure with the source code for the shader processors of the video adapter pipeline
+     * @brief Reallocates the index buffer with new data. The pipe must be bound, the index buffer becomes the part of
+     * the pipe's VAO.
+     * @param data - the pointer to a new index data
+     * @param count - the data size in bytes
+     */
+    void allocateIndices(const void* data, int count);
+
+    /**
+     * @brief Reallocates the vertex buffer with the data segments
+     * @param segments - the container with the data segments
+     */
+    void allocate(const BufferSegments& segments);
+
+    /**
+     * @brief Reallocates the index buffer with the data segments. The pipe must be bound.
+     * @param segments - the container with the data segments
      */
-    void addShaderFromSourceCode(const Shader& shader);
+    void allocateIndices(const BufferSegments& segments);
 
     /**
      * @brief Sets the attributes for the OpenGL pipeline rendering
@@ -71,14 +128,27 @@ class Pipe : public QOpenGLFunctions
      */
     void addAttributes(const Attributes& attributes);
 
+    /**
+     * @brief Shifts the attributes by the number of the vertices. It's the fallback of the base vertex draws for the
+     * contexts without them (see Capabilities::isBaseVertex). The pipe must be bound.
+     * @param base_vertex - the number of the vertices
+     */
+    void setBaseVertex(GLint base_vertex);
+
     /** setters */
     void setView(const Vec3& position, const Mat4& projection, const Mat4& view);
     void setTransform(const Mat4& model);
 
+    /** getters */
+    inline GLint getBaseVertex() const { return baseVertex; }
+
  protected:
-    QOpenGLShaderProgram program;
+    std::shared_ptr<QOpenGLShaderProgram> program;
     QOpenGLVertexArrayObject vao;
-    QOpenGLBuffer vbo;
+    std::shared_ptr<QOpenGLBuffer> vbo;
+    std::shared_ptr<QOpenGLBuffer> ibo;
+    Attributes vertexAttributes;
+    GLint baseVertex{0};
 };
 
 /**
@@ -92,12 +162,227 @@ class PipeExt : public Pipe
     using Ptr  = std::shared_ptr<PipeExt>;
     using Pack = std::map<PipeID, PipeExt::Ptr>;
 
-    PipeExt(const Shader& shader, const void* pipe_data, int count, const Pipe::Attributes& attributes);
+    PipeExt(const Shader& shader, const void* pipe_data, int count, const Pipe::Attributes& attributes,
+            const void* index_data = nullptr, int index_count = 0);
+    PipeExt(const Shader& shader, const BufferSegments& vertex_segments, const Pipe::Attributes& attributes,
+            const BufferSegments& index_segments = {});
+    PipeExt(const Resources& resources, const Pipe::Attributes& attributes);
 
     /** setters */
     void setLight(const Light& light);
     void setColor(const Color& color);
     void setAlfa(float alfa);
+    void setTextureUnits(uint texture_unit, uint atlas_unit);
+    void setAtlasRegion(int layer, const QVector4D& rect);
+};
+
+/**
+ * Class IndirectPipe
+ * @brief The pipe drawing the static items by the multi-draw indirect commands. The items' data (the transformation,
+ * the color and the atlas region) are the instanced attributes, each command picks its item by the base instance.
+ * The table of the items persists between the frames, only its changed records are uploaded. The commands could be
+ * culled by the compute pass (defaults::shaders::kCulling) instead of the CPU.
+ * The pipe's shaders must be built with SCENE_INDIRECT defined.
+ */
+class IndirectPipe : public PipeExt
+{
+ public:
+    using Ptr  = std::shared_ptr<IndirectPipe>;
+    using Pack = std::map<PipeID, IndirectPipe::Ptr>;
+
+    // the per draw attributes (the shader's locations 3 - 13) and the bounds for the GPU culling
+    struct ItemData
+    {
+        std::array<float, 16> model;
+        std::array<float, 9> normal;
+        std::array<float, 4> color;  // rgb and alfa
+        std::array<float, 4> atlasRect;
+        float atlasLayer;
+        std::array<float, 4> idColor;    // the selection pass color
+        std::array<float, 3> boundsMin;  // the world bounds
+        std::array<float, 3> boundsMax;
+    };
+    using ItemDataPack = std::vector<ItemData>;
+
+    /**
+     * @brief Constructor for the IndirectPipe
+     * @param resources - the program built with SCENE_INDIRECT and the static geometry buffers
+     * @param attributes - the vertex attributes
+     * @param selection_program - the selection pipe's program built with SCENE_INDIRECT (see setSelection)
+     */
+    IndirectPipe(const Resources& resources, const Pipe::Attributes& attributes,
+                 const std::shared_ptr<QOpenGLShaderProgram>& selection_program = nullptr);
+    ~IndirectPipe();
+
+    /**
+     * @brief Sets the record of the items' table, it's uploaded by the next uploadItems if it differs from the current
+     * @param index - the record's index, the commands refer the item by it
+     * @param item - the item's data
+     */
+    void setItem(GLuint index, const ItemData& item);
+
+    /**
+     * @brief Uploads the changed records of the items' table. The pipe must be bound.
+     */
+    void uploadItems();
+
+    /**
+     * @brief Adds the command drawing the item's geometry. The commands of the run (drawn by the single call) must be
+     * added one after another.
+     * @param geometry - the item's geometry
+     * @param item_index - the index of the item's data
+     * @param is_new_run - true if the command starts the new run
+     * @return the index of the command
+     */
+    GLsizei addCommand(const GeometryData& geometry, GLuint item_index, bool is_new_run);
+
+    /**
+     * @brief Uploads the commands added since the previous upload unless they are the same. With the GPU culling
+     * they're uploaded as the culling's candidates.
+     */
+    void uploadCommands();
+
+    /**
+     * @brief Culls the uploaded commands by the frustum on the GPU, does nothing without the GPU culling
+     * @param culling_program - the culling program (defaults::shaders::kCulling)
+     * @param frustum - the camera's frustum
+     */
+    void cull(QOpenGLShaderProgram& culling_program, const CameraState::Planes& frustum);
+
+    /**
+     * @brief Draws the run of the uploaded commands by the single call. The pipe must be bound.
+     * @param mode - the primitives' type
+     * @param is_indexed - the commands' type
+     * @param first - the index of the run's first command
+     * @param count - the number of the run's commands
+     */
+    void draw(GLenum mode, bool is_indexed, GLsizei first, GLsizei count);
+
+    /** setters */
+    inline void setGpuCulling(bool is_gpu_culling) { isGpuCulling = is_gpu_culling; }
+    void setSelection(bool is_selection);  // the selection program draws the items' ID colors
+
+ private:
+    // the not indexed command takes the base instance in place of the base vertex
+    struct Command
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // the layout of the culling shader's Candidate, the draws read the commands right from it without the culling
+    struct Candidate
+    {
+        Command command;
+        GLuint item;
+        GLuint run;
+        GLuint runFirst;
+    };
+
+    using MultiDrawArraysIndirect        = void(QOPENGLF_APIENTRYP)(GLenum, const void*, GLsizei, GLsizei);
+    using MultiDrawElementsIndirect      = void(QOPENGLF_APIENTRYP)(GLenum, GLenum, const void*, GLsizei, GLsizei);
+    using MultiDrawArraysIndirectCount   = void(QOPENGLF_APIENTRYP)(GLenum, const void*, GLintptr, GLsizei, GLsizei);
+    using MultiDrawElementsIndirectCount = void(QOPENGLF_APIENTRYP)(GLenum, GLenum, const void*, GLintptr, GLsizei,
+                                                                    GLsizei);
+
+    bool isCompacting() const;
+
+    std::shared_ptr<QOpenGLShaderProgram> drawProgram;
+    std::shared_ptr<QOpenGLShaderProgram> selectionProgram;
+    QOpenGLBuffer itemBuffer;
+    ItemDataPack items;  // the copy of the GPU table
+    std::vector<std::pair<GLuint, GLuint>> dirtyRanges;
+    size_t allocatedItemsCount{0};
+    GLuint commandBuffer{0};
+    GLuint candidateBuffer{0};
+    GLuint countBuffer{0};
+    std::vector<Candidate> candidates;
+    std::vector<Candidate> uploadedCandidates;
+    GLuint uploadedBuffer{0};
+    bool isGpuCulling{false};
+    MultiDrawArraysIndirect multiDrawArraysIndirect{nullptr};
+    MultiDrawElementsIndirect multiDrawElementsIndirect{nullptr};
+    MultiDrawArraysIndirectCount multiDrawArraysIndirectCount{nullptr};
+    MultiDrawElementsIndirectCount multiDrawElementsIndirectCount{nullptr};
+};
+
+/**
+ * Class BatchPipe
+ * @brief The pipe drawing the batch of the frozen items (see Scene::freeze) by the single call. The pipe takes the
+ * program of the indirect draws (the shaders built with SCENE_INDIRECT): the batch's vertices carry the items' colors
+ * and ID colors, the rest of the per draw attributes are the constant ones, since the vertices are transformed already.
+ */
+class BatchPipe : public PipeExt
+{
+ public:
+    using Ptr  = std::shared_ptr<BatchPipe>;
+    using Pack = std::vector<BatchPipe::Ptr>;
+
+    /**
+     * @brief Constructor for the BatchPipe, the pipe creates its own vertex buffer
+     * @param program - the batch pipe's program built with SCENE_INDIRECT
+     * @param selection_program - the selection pipe's program built with SCENE_INDIRECT (see setSelection)
+     */
+    BatchPipe(const std::shared_ptr<QOpenGLShaderProgram>& program,
+              const std::shared_ptr<QOpenGLShaderProgram>& selection_program);
+
+    /**
+     * @brief Uploads the batch's vertices the first time or after they're appended or compacted, otherwise only the
+     * vertices of the items thawed since the previous upload
+     * @param batch - the batch, it must be the same one for each call
+     */
+    void upload(const Batch& batch);
+
+    /**
+     * @brief Draws the range of the batch's vertices. The pipe must be bound.
+     * @param mode - the primitives' type
+     * @param first - the first vertex
+     * @param count - the number of the vertices
+     */
+    void draw(GLenum mode, GLint first, GLsizei count);
+
+    /** setters */
+    void setSelection(bool is_selection);              // the selection program draws the items' ID colors
+    void setRegion(int layer, const QVector4D& rect);  // the atlas region of the batch's texture
+
+ private:
+    std::shared_ptr<QOpenGLShaderProgram> drawProgram;
+    std::shared_ptr<QOpenGLShaderProgram> selectionProgram;
+    bool isUploaded{false};
+    uint64_t uploadedRevision{0};
+};
+
+/**
+ * Class ScreenPipe
+ * @brief The pipe for the 2D rendering over the scene. The vertices are given in the screen coordinates.
+ */
+class ScreenPipe : public Pipe
+{
+ public:
+    using Ptr = std::shared_ptr<ScreenPipe>;
+
+    ScreenPipe(const Shader& shader, const Pipe::Attributes& attributes);
+
+    /** setters */
+    void setViewport(const QSizeF& size);
+};
+
+/**
+ * Class TextPipe
+ * @brief The pipe for the text rendering. The text vertices are given in the screen coordinates.
+ */
+class TextPipe : public ScreenPipe
+{
+ public:
+    using Ptr = std::shared_ptr<TextPipe>;
+
+    TextPipe(const Shader& shader, const Pipe::Attributes& attributes);
+
+    /** setters */
+    void setGlyphsUnit(uint unit);
 };
 
 }  // namespace gl_scene
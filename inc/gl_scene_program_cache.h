@@ -0,0 +1,68 @@
+#pragma once
+
+#include "gl_scene_types.h"
+#include "gl_scene_capabilities.h"
+#include <QOpenGLShaderProgram>
+#include <QOpenGLExtraFunctions>
+
+namespace gl_scene
+{
+
+/**
+ * The ProgramCache Class
+ * @brief The class builds the shader programs. The version header of the context is prepended to the shaders' source
+ * code (see Capabilities), the programs with the same source code are built once. The programs are compiled and linked
+ * without waiting for the result, so the driver could build them in parallel (the KHR_parallel_shader_compile
+ * extension is enabled where it's available), the results are checked by the finish.
+ * The linked programs' binaries are kept in the cache directory, they are keyed by the driver and the source code, so
+ * the next launches load them without the compilation.
+ */
+class ProgramCache
+{
+ public:
+    using Program = std::shared_ptr<QOpenGLShaderProgram>;
+
+    /**
+     * @brief Constructor for the ProgramCache. Must be called with the current OpenGL context.
+     * @param cache_dir - the program binaries' directory (if empty the binaries are not cached)
+     */
+    explicit ProgramCache(const QString& cache_dir = {});
+
+    /**
+     * @brief Starts the program building. Must be called with the current OpenGL context.
+     * @param shader - the structure with the source code for the shader processors of the video adapter pipeline
+     * @param defines - the preprocessor definitions of the shaders (e.g. "#define NAME\n")
+     * @return the program, it's ready to use after the finish
+     */
+    Program add(const Shader& shader, const std::string& defines = {});
+
+    /**
+     * @brief Waits for the programs started by the add and stores the binaries of the built ones to the cache
+     * directory. The failed programs' logs are written to the warnings, such programs stay not linked (see
+     * QOpenGLShaderProgram::isLinked). Must be called with the current OpenGL context.
+     */
+    void finish();
+
+ private:
+    struct Entry
+    {
+        Program program;
+        QString filename;
+        std::vector<GLuint> shaders;
+        bool isPending;
+        bool isLoaded;
+    };
+
+    bool load(Entry& entry);
+    void compile(Entry& entry, const Shader& shader);
+    void store(const Entry& entry);
+
+    QOpenGLExtraFunctions* mFunctions;
+    Capabilities mCapabilities;
+    QString mCacheDir;
+    QByteArray mDriver;
+    bool mIsBinarySupported{false};
+    std::map<QByteArray, Entry> mEntries;
+};
+
+}  // namespace gl_scene
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "gl_scene_defaults.h"
+
+namespace gl_scene
+{
+
+/**
+ * The QualityController Class
+ * @brief The class chooses the quality level of each frame. While the user interacts with the view, the quality is
+ * lowered step by step until the frame time fits the target one and is raised back when there is a spare time. Once
+ * the interaction stops, the quality is refined by one level per frame up to the full one.
+ */
+class QualityController
+{
+ public:
+    /**
+     * @brief Constructor for the QualityController
+     * @param target_frame_time - the frame time to be held during the interaction in milliseconds
+     * @param levels - the quality levels from the full quality down to the coarsest one
+     */
+    explicit QualityController(float target_frame_time          = defaults::quality::kTargetFrameTime,
+                               const QualityLevel::Pack& levels = defaults::quality::kLevels);
+
+    /**
+     * @brief Must be called at the frame's start
+     * @param is_interacting - true if the user interacts with the view (e.g. drags the camera)
+     * @return the quality level of the frame
+     */
+    const QualityLevel& beginFrame(bool is_interacting);
+
+    /**
+     * @brief Passes the measured frame time (it could be the time of one of the previous frames)
+     * @param frame_time - the frame time in milliseconds
+     */
+    void addFrameTime(float frame_time);
+
+    /** setters */
+    inline void setTargetFrameTime(float target_frame_time) { mTargetFrameTime = target_frame_time; }
+
+    /** getters */
+    inline bool isRefining() const { return !mIsInteracting && mLevel > 0; }
+    inline const QualityLevel& getLevel() const { return mLevels[mLevel]; }
+
+ private:
+    float mTargetFrameTime;
+    QualityLevel::Pack mLevels;
+    size_t mLevel{0};
+    int mFastFrameCount{0};
+    bool mIsInteracting{false};
+};
+
+}  // namespace gl_scene
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "gl_scene.h"
+#include "gl_scene_pipe.h"
+#include "gl_scene_program_cache.h"
+#include "gl_scene_texture_manager.h"
+#include <QOpenGLContext>
+#include <mutex>
+
+namespace gl_scene
+{
+
+/**
+ * The ResourceManager Class
+ * @brief The class keeps the scene's GPU resources which could be shared by the contexts of the share group: the
+ * compiled programs, the geometry buffers and the textures. The resources are created once per the share group and the
+ * scene, the views of the group hold the same manager, so it's released with the last of them. Only the VAOs (which
+ * aren't shared between the contexts) are created by each view.
+ */
+class ResourceManager
+{
+ public:
+    using Ptr           = std::shared_ptr<ResourceManager>;
+    using ReadyCallback = TextureManager::ReadyCallback;
+
+    /**
+     * @brief Returns the manager of the current context's share group for the scene, the manager is created if the
+     * group has none yet. Must be called with the current OpenGL context.
+     * @param scene - the scene
+     * @param cache_dir - the texture cache directory (it's used by the first call within the group only)
+     * @param is_compressed - the block compression flag of the cached textures (the same as the cache_dir)
+     * @param program_cache_dir - the program binaries' directory (the same as the cache_dir)
+     * @return shared pointer to the manager
+     */
+    static Ptr acquire(const Scene::Ptr& scene, const QString& cache_dir = {}, bool is_compressed = false,
+                       const QString& program_cache_dir = {});
+
+    ~ResourceManager();
+
+    /**
+     * @brief Adds the callback called when the decoded textures are ready for the upload. It's called from the worker
+     * threads.
+     * @param owner - the callback's owner (e.g. the view), it's used to remove the callback
+     * @param callback - the callback
+     */
+    void addReadyCallback(const void* owner, const ReadyCallback& callback);
+
+    /**
+     * @brief Removes the callbacks added by the owner
+     * @param owner - the callback's owner
+     */
+    void removeReadyCallback(const void* owner);
+
+    /** getters */
+    const Pipe::Resources& getResources(PipeID pipe_id) const;
+    const Pipe::Resources& getIndirectResources(PipeID pipe_id) const;  // the programs built with SCENE_INDIRECT
+    inline const std::shared_ptr<QOpenGLShaderProgram>& getCullingProgram() const { return mCullingProgram; }
+    inline const TextureManager::Ptr& getTextureManager() const { return mTextureManager; }
+
+ private:
+    using Key = std::pair<const QOpenGLContextGroup*, const Scene*>;
+
+    ResourceManager(const Key& key, const Scene::Ptr& scene, const QString& cache_dir, bool is_compressed,
+                    const QString& program_cache_dir);
+
+    Key mKey;
+    std::map<PipeID, Pipe::Resources> mResources;
+    std::map<PipeID, Pipe::Resources> mIndirectResources;
+    std::shared_ptr<QOpenGLShaderProgram> mCullingProgram;  // null without the compute shaders
+    Pipe::Resources mEmpty;
+    TextureManager::Ptr mTextureManager;
+    std::mutex mCallbacksMutex;
+    std::vector<std::pair<const void*, ReadyCallback>> mCallbacks;
+};
+
+}  // namespace gl_scene
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "gl_scene_types.h"
+#include <QOpenGLBuffer>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <mutex>
+
+namespace gl_scene
+{
+
+/**
+ * The StreamingTexture Class
+ * @brief The class represents the texture which content is updated by the frames from the producer thread (e.g. the
+ * video feed). The frames are copied straight into the mapped pixel unpack buffers (double-buffered) and the render
+ * thread transfers the latest one into the texture by glTexSubImage2D. The frames are dropped while the render thread
+ * is behind, so neither the producer nor the render thread waits for each other.
+ */
+class StreamingTexture
+{
+ public:
+    using Ptr           = std::shared_ptr<StreamingTexture>;
+    using ReadyCallback = std::function<void()>;
+
+    /**
+     * @brief Constructor for the StreamingTexture
+     * @param width - the frames' width
+     * @param height - the frames' height
+     */
+    StreamingTexture(int width, int height);
+
+    /**
+     * @brief Passes the frame to the texture. Could be called from any thread.
+     * @param frame - the frame of the texture's size (the frame is converted into the RGBA8888 format if necessary)
+     * @return true if the frame is accepted, false if it's dropped
+     */
+    bool pushFrame(const QImage& frame);
+
+    /**
+     * @brief Transfers the latest frame into the texture. Must be called with the current OpenGL context.
+     * @return true if the texture has been updated
+     */
+    bool upload();
+
+    /**
+     * @brief Destroys the OpenGL resources of the texture and drops the callback, the callback being called is waited
+     * for. Must be called with the current OpenGL context.
+     */
+    void destroy();
+
+    /** setters */
+    void setReadyCallback(const ReadyCallback& callback);  // the previous callback being called is waited for
+
+    /** getters */
+    inline const Texture::Ptr& getTexture() const { return mTexture; }
+    inline uint64_t getDroppedCount() const { return mDroppedCount; }
+
+ private:
+    enum class SlotState
+    {
+        kUnmapped,
+        kFree,
+        kWriting,
+        kFilled
+    };
+
+    struct Slot
+    {
+        QOpenGLBuffer buffer{QOpenGLBuffer::PixelUnpackBuffer};
+        uchar* data{nullptr};
+        SlotState state{SlotState::kUnmapped};
+        uint64_t frame{0};
+    };
+
+    uchar* map(Slot& slot);
+
+    int mWidth;
+    int mHeight;
+    int mSize;
+    Texture::Ptr mTexture;
+    std::array<Slot, 2> mSlots;
+    std::mutex mMutex;
+    std::condition_variable mWritten;
+    ReadyCallback mCallback;
+    int mCallingCount{0};  // the producers calling the callback now
+    uint64_t mFrame{0};
+    std::atomic<uint64_t> mDroppedCount{0};
+};
+
+}  // namespace gl_scene
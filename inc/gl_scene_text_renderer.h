@@ -0,0 +1,91 @@
+#pragma once
+
+#include "gl_scene_pipe.h"
+#include "gl_scene_label_placer.h"
+#include <QRawFont>
+#include <unordered_map>
+
+namespace gl_scene
+{
+
+/**
+ * The TextRenderer Class
+ * @brief The class renders the scene's text items within the OpenGL pass.
+ * The glyphs are rasterized once into the glyph atlas (the coverage texture), the text layouts are cached per (font,
+ * text) across the frames, the quads of the placed labels are built in bulk and rendered by the single draw call.
+ */
+class TextRenderer
+{
+ public:
+    using Ptr = std::shared_ptr<TextRenderer>;
+
+    /**
+     * @brief Constructor for the TextRenderer. Must be called with the current OpenGL context.
+     */
+    TextRenderer();
+
+    /**
+     * @brief Renders the labels. Must be called with the current OpenGL context.
+     * @param labels - the labels selected by the LabelPlacer
+     * @param size - the viewport size in the logical pixels
+     * @param pixel_ratio - the device pixel ratio
+     */
+    void render(const LabelPlacer::Label::Pack& labels, const QSize& size, qreal pixel_ratio);
+
+    /**
+     * @brief Resolves the layouts of the items changed since the previous call, the others keep their layouts
+     * @param items - the container with the text items
+     * @param revisions - the items' revisions (the item is changed when its revision is)
+     * @param pixel_ratio - the device pixel ratio
+     */
+    void update(const TextItem::Pack& items, const std::vector<uint64_t>& revisions, qreal pixel_ratio);
+
+    /**
+     * @brief Returns the item's text bounds relative to the baseline origin
+     * @param index - the item's index in the container passed to the update
+     * @return the bounds in the logical pixels
+     */
+    inline const QRect& getBounds(size_t index) const { return mItemLayouts[index]->bounds; }
+
+ private:
+    struct Glyph
+    {
+        QRectF rect;  // the glyph's rect relative to the baseline origin in device pixels
+        QRectF uv;
+    };
+
+    struct Font
+    {
+        QRawFont raw;
+        std::unordered_map<quint32, Glyph> glyphs;
+    };
+
+    struct Layout
+    {
+        Font* font;
+        QVector<quint32> glyphIndexes;
+        QVector<QPointF> advances;  // in the device pixels
+        QRect bounds;
+    };
+
+    void build(const LabelPlacer::Label::Pack& labels, qreal pixel_ratio);
+    Font& getFont(const QFont& font, qreal pixel_ratio);
+    const Layout& getLayout(const TextItem& item, qreal pixel_ratio);
+    const Glyph* getGlyph(Font& font, quint32 glyph_index);
+    void resetAtlas();
+
+    TextPipe::Ptr mPipe;
+    Texture::Ptr mAtlas;
+    std::map<QString, Font> mFonts;
+    std::map<std::pair<QString, QString>, Layout> mLayouts;
+    std::vector<const Layout*> mItemLayouts;
+    std::vector<uint64_t> mItemRevisions;
+    qreal mPixelRatio{0.0};
+    Shelves mShelves;
+    VertexPack mVertices;
+    IndexPack mIndices;
+    int mIndexCount{0};
+    bool mIsAtlasFull{false};
+};
+
+}  // namespace gl_scene
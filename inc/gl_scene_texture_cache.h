@@ -0,0 +1,67 @@
+#pragma once
+
+#include "gl_scene_types.h"
+#include <QFile>
+
+namespace gl_scene
+{
+
+/**
+ * The TextureCache Class
+ * @brief The class represents the KTX texture container mapped into memory.
+ * The container keeps the full mip chain of the texture in the GPU ready form (RGBA8 or BC1 compressed), so the levels
+ * are uploaded straight from the mapped memory without decoding, mirroring or mipmaps generation.
+ */
+class TextureCache
+{
+ public:
+    using Ptr = std::shared_ptr<TextureCache>;
+
+    struct Level
+    {
+        int width;
+        int height;
+        const uchar* data;
+        int size;
+    };
+    using Levels = std::vector<Level>;
+
+    /**
+     * @brief Maps the texture container file into memory
+     * @param filename - the container's file name
+     * @return shared pointer to the mapped container or nullptr if the file is absent or has unsupported format
+     */
+    static Ptr open(const QString& filename);
+
+    /**
+     * @brief Builds the mip chain of the image and writes it into the container file
+     * @param filename - the container's file name
+     * @param image - the image in the texture orientation (already mirrored)
+     * @param is_compressed - the block compression flag (only opaque images are compressed, by BC1)
+     * @return true if the container has been written
+     */
+    static bool write(const QString& filename, const QImage& image, bool is_compressed);
+
+    /**
+     * @brief Builds the container's file name by the content hash of the source image and the requested format, so the
+     * containers written for the other format aren't taken
+     * @param source_filename - the source image's file name
+     * @param is_compressed - the block compression flag the container is written with (see write)
+     * @param cache_dir - the cache directory (if empty the container is placed next to the source file)
+     * @return the container's file name or empty string if the source file can't be read
+     */
+    static QString cacheFilename(const QString& source_filename, bool is_compressed, const QString& cache_dir = {});
+
+    /** getters */
+    inline const Levels& getLevels() const { return mLevels; }
+    inline bool isCompressed() const { return mIsCompressed; }
+
+ private:
+    TextureCache() = default;
+
+    QFile mFile;
+    Levels mLevels;
+    bool mIsCompressed{false};
+};
+
+}  // namespace gl_scene
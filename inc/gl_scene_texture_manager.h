@@ -0,0 +1,124 @@
+#pragma once
+
+#include "gl_scene_texture_cache.h"
+#include <QVector4D>
+#include <functional>
+#include <mutex>
+#include <deque>
+
+namespace gl_scene
+{
+
+/**
+ * The TextureManager Class
+ * @brief The class provides the asynchronous loading of the scene's textures.
+ * The images are decoded on the worker threads and uploaded to the GPU on the render thread within the per frame byte
+ * budget. The placeholder texture is used for rendering until the texture is uploaded.
+ * Small textures marked as atlased (see Texture::isAtlased) are packed into the layers of the texture arrays (atlas
+ * pages), so the items with different textures are rendered without rebinding. Other textures could be kept in the
+ * texture cache (KTX containers with the precomputed mipmaps), they are uploaded level by level from the coarsest one
+ * and refined during the next frames.
+ */
+class TextureManager
+{
+ public:
+    using Ptr           = std::shared_ptr<TextureManager>;
+    using ReadyCallback = std::function<void()>;
+
+    struct Region
+    {
+        Texture::Ptr data;
+        int layer{-1};  // the layer of the atlas page (-1 if the texture is standalone)
+        QVector4D rect{0.0f, 0.0f, 1.0f, 1.0f};
+    };
+
+    /**
+     * @brief Constructor for the TextureManager
+     * @param textures_map - the container with textures. The textures with preset data are used as is.
+     * @param cache_dir - the texture cache directory (if empty the textures are not cached)
+     * @param is_compressed - the block compression flag of the cached textures (the GPU must support S3TC)
+     */
+    explicit TextureManager(const TexturesMap& textures_map, const QString& cache_dir = {},
+                            bool is_compressed = false);
+    ~TextureManager();
+
+    /**
+     * @brief Returns the texture region. If the texture is not uploaded yet the placeholder is returned and the image
+     * decoding is started. Must be called with the current OpenGL context.
+     * @param texture_id - the ID of the texture
+     * @return the texture region (the region has no data if the texture is unknown)
+     */
+    const Region& get(TextureID texture_id);
+
+    /**
+     * @brief Uploads the decoded images to the GPU. Must be called with the current OpenGL context.
+     * @param byte_budget - the amount of bytes allowed to upload (at least one image is uploaded anyway)
+     * @return true if there are decoded images left for the next frames
+     */
+    bool upload(qint64 byte_budget);
+
+    /** setters */
+    void setReadyCallback(const ReadyCallback& callback);
+
+    /** getters */
+    inline bool isLoading() const { return mLoadingCount > 0; }
+
+ private:
+    enum class State
+    {
+        kIdle,
+        kLoading,
+        kReady,
+        kFailed
+    };
+
+    struct Entry
+    {
+        QString filename;
+        bool isAtlased;
+        State state;
+        Region region;
+        TextureCache::Ptr cache;  // the cache is kept while its levels are uploaded
+        int level{0};
+    };
+
+    struct DecodedImage
+    {
+        TextureID textureId;
+        QImage image;
+        bool isPadded;
+        TextureCache::Ptr cache;
+    };
+
+    // the queue is shared with the worker threads, so it outlives the manager while decoding is in progress
+    struct DecodedQueue
+    {
+        std::mutex mutex;
+        std::deque<DecodedImage> images;
+        ReadyCallback callback;
+    };
+
+    struct AtlasPage
+    {
+        Texture::Ptr data;
+        std::vector<Shelves> layers;
+        bool isDirty{false};
+    };
+
+    void load(TextureID texture_id, const QString& filename, bool is_atlased);
+    qint64 uploadLevel(TextureID texture_id);
+    bool pack(const QImage& image, Region& region);
+    const Region& getPlaceholder();
+
+    std::map<TextureID, Entry> mEntries;
+    std::vector<AtlasPage> mAtlasPages;
+    std::deque<TextureID> mPendingLevels;
+    QString mCacheDir;
+    bool mIsCompressed;
+    std::shared_ptr<DecodedQueue> mQueue;
+    Region mPlaceholder;
+    Region mEmpty;
+    int mLoadingCount{0};
+};
+
+}  // namespace gl_scene
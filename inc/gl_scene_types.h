@@ -18,6 +18,7 @@ typedef uint32_t MeshID;
 typedef uint32_t PipeID;
 typedef uint32_t ItemID;
 typedef uint32_t TextureID;
+typedef uint32_t TextItemID;
 
 using Mat4       = QMatrix4x4;
 using Mat3       = QMatrix3x3;
@@ -25,6 +26,7 @@ using Vec3       = QVector3D;
 using Vec2       = QVector2D;
 using Vertex     = std::array<float, 8>;
 using VertexPack = std::vector<Vertex>;
+using IndexPack  = std::vector<GLuint>;
 using Point2     = std::pair<float, float>;
 using Point2Pack = std::vector<Point2>;
 using Point3     = std::array<float, 3>;
@@ -44,8 +46,29 @@ struct GeometryData
 {
     GLint first;
     GLsizei count;
+    bool isIndexed{false};
+    GLint baseVertex{0};
+    Vec3 min;  // the mesh's bounding box in the local coordinates
+    Vec3 max;
 };
 
+struct BufferSegment
+{
+    const void* data;
+    int size;
+};
+
+using BufferSegments = std::vector<BufferSegment>;
+
+struct Shelf
+{
+    int x;
+    int y;
+    int height;
+};
+
+using Shelves = std::vector<Shelf>;
+
 struct FigureLine
 {
     float width;
@@ -138,11 +161,25 @@ struct Shader
 
 struct RenderAttributes
 {
+    inline bool operator==(const RenderAttributes& other) const
+    {
+        return lineWidth == other.lineWidth && enableAttributes == other.enableAttributes &&
+               disableAttributes == other.disableAttributes;
+    }
+
     float lineWidth;
     std::vector<GLenum> enableAttributes;
     std::vector<GLenum> disableAttributes;
 };
 
+struct QualityLevel
+{
+    using Pack = std::vector<QualityLevel>;
+    int samples;         // the MSAA samples, 0 if the multisampling is off
+    float scale;         // the render resolution relative to the viewport, the scaled levels aren't multisampled
+    bool isTextVisible;  // the labels are skipped if false
+};
+
 struct RenderParameters
 {
     RenderParameters(GLenum render_mode = GL_TRIANGLES, float render_alfa = 1.0f,
@@ -167,6 +204,7 @@ struct TextItem
     int shiftX;
     int shiftY;
     bool isHoldInScreen;
+    int priority{0};  // the overlapping labels are hidden in favor of the one with the higher priority
 };
 
 struct Texture
@@ -174,6 +212,7 @@ struct Texture
     using Ptr = std::shared_ptr<QOpenGLTexture>;
     QString filename;
     Ptr data;
+    bool isAtlased{false};  // the small texture could be packed into the atlas, its coordinates must stay in [0, 1]
 };
 
 using TexturesMap = std::map<TextureID, Texture>;
@@ -33,4 +33,50 @@ extern Point3Pack crossPoint(const Point3& a1, const Point3& a2, const Point3& b
  */
 extern Point3Pack crossPoints(const Point3& p1, const Point3& p2, const Point3Pack& figure);
 
+/**
+ * @brief Builds the cache file name by the content hash of the source file. The hash is remembered in the stamp file
+ * keyed by the source's path, size and modification time, so the content is hashed again only when those change.
+ * @param source_filename - the source file name
+ * @param cache_dir - the cache directory (if empty the cache file is placed next to the source file)
+ * @param suffix - the cache file suffix
+ * @return the cache file name or empty string if the source file can't be read
+ */
+extern QString cacheFilename(const QString& source_filename, const QString& cache_dir, const QString& suffix);
+
+/**
+ * @brief Packs the rectangle into the square area divided into the shelves (the first fitting shelf is used)
+ * @param shelves - the container with the area's shelves
+ * @param area_size - the size of the area's side
+ * @param size - the rectangle's size
+ * @param position - the rectangle's position within the area
+ * @return true if the rectangle has been packed
+ */
+extern bool packShelf(Shelves& shelves, int area_size, const QSize& size, QPoint& position);
+
+/**
+ * @brief Transforms the points by the matrix with the perspective division (SIMD where it's available)
+ * @param transformation - the transformation matrix
+ * @param points - the contiguous x, y, z triples
+ * @param count - the number of the points
+ * @param result - the contiguous x, y, z triples of the transformed points (could be the same as the points)
+ */
+extern void transformPoints(const Mat4& transformation, const float* points, size_t count, float* result);
+
+/**
+ * @brief Calculates the axis aligned box of the vertices' positions
+ * @param vertices - the vertices
+ * @param count - the number of the vertices
+ * @param min - the box's minimal corner (zero for no vertices)
+ * @param max - the box's maximal corner (zero for no vertices)
+ */
+extern void calculateBounds(const Vertex* vertices, size_t count, Vec3& min, Vec3& max);
+
+/**
+ * @brief Transforms the axis aligned box by the affine matrix, the result is the box bounding the transformed one
+ * @param transformation - the affine transformation matrix
+ * @param min - the box's minimal corner, it's replaced by the transformed box's one
+ * @param max - the box's maximal corner, it's replaced by the transformed box's one
+ */
+extern void transformBounds(const Mat4& transformation, Vec3& min, Vec3& max);
+
 }  // namespace gl_scene
@@ -3,12 +3,23 @@
 #include "gl_scene.h"
 #include "gl_scene_pipe.h"
 #include "gl_scene_camera.h"
-#include "gl_scene_glass.h"
 #include "gl_scene_manipulator.h"
+#include "gl_scene_texture_manager.h"
+#include "gl_scene_resource_manager.h"
+#include "gl_scene_streaming_texture.h"
+#include "gl_scene_text_renderer.h"
+#include "gl_scene_overlay_renderer.h"
+#include "gl_scene_frame_scheduler.h"
+#include "gl_scene_quality_controller.h"
+#include "gl_scene_capabilities.h"
+#include "gl_scene_occlusion_culler.h"
 #include <QOpenGLWidget>
 #include <QOpenGLBuffer>
 #include <QOpenGLFunctions>
 #include <QOpenGLVertexArrayObject>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTimerQuery>
+#include <QTimer>
 #include <set>
 
 /**
@@ -35,12 +46,58 @@ class GLSceneView : public QOpenGLWidget, public QOpenGLFunctions
      */
     void zoomCamera(int delta);
 
+    /**
+     * @brief Adds the streaming texture. Its latest frame is uploaded before each frame rendering. The texture is used
+     * by the items through the Item::texture.
+     * @param texture - the shared pointer to the streaming texture
+     */
+    void addStreamingTexture(const gl_scene::StreamingTexture::Ptr& texture);
+
+    /**
+     * @brief Adds the viewport rendering the scene by its own camera over the main one (e.g. the split or the
+     * picture-in-picture). The items are traversed and uploaded once per frame for all viewports, only the culling and
+     * the drawing are done per camera. The text, the overlay and the picking use the main camera.
+     * @param area - the viewport's area relative to the widget's size (0..1, y goes down)
+     * @param camera - the viewport's camera, its viewport size is kept by the view
+     * @return the viewport's index
+     */
+    size_t addViewport(const QRectF& area, const gl_scene::Camera::Ptr& camera);
+
+    /**
+     * @brief Removes the viewport added by the addViewport
+     * @param index - the viewport's index, the indices of the next viewports are shifted
+     */
+    void removeViewport(size_t index);
+
+    /**
+     * @brief Requests the frame after the changes the view can't track (e.g. the items' fields changed directly)
+     */
+    void invalidate();
+
+    /**
+     * @brief Starts the animation, the view renders continuously until all started animations are stopped
+     */
+    void startAnimation();
+
+    /**
+     * @brief Stops the animation started by the startAnimation
+     */
+    void stopAnimation();
+
     /** setters */
-    inline void setScene(gl_scene::Scene::Ptr scene) { mScene = scene; }
+    void setScene(gl_scene::Scene::Ptr scene);
     void setManipulator(gl_scene::Manipulator::Ptr manipulator);
-    inline void setBackgroundColor(const gl_scene::Color& color) { mBackgroundColor = color; }
-    inline void setSelectedItemIds(const gl_scene::Item::IdPack& ids) { mSelectedItemIds = ids; }
-    inline void setTextVisibile(bool is_visible) { mIsTextVisible = is_visible; }
+    void setBackgroundColor(const gl_scene::Color& color);
+    void setSelectedItemIds(const gl_scene::Item::IdPack& ids);
+    void setTextVisibile(bool is_visible);
+    void setMainViewport(const QRectF& area);
+    inline void setLabelOcclusion(bool is_occluded) { mIsLabelOcclusion = is_occluded; }
+    inline void setGpuCulling(bool is_enabled) { mIsGpuCulling = is_enabled; }  // needs the compute shaders
+    void setOcclusionCulling(bool is_enabled);
+    inline void setUploadBudget(qint64 byte_budget) { mUploadBudget = byte_budget; }
+    inline void setTargetFrameTime(float frame_time) { mQualityController.setTargetFrameTime(frame_time); }
+    void setTextureCache(const QString& cache_dir, bool is_compressed = false);
+    void setProgramCache(const QString& cache_dir);
     void setRectZoomMode(bool mode);
     void setRectSelectionMode(bool mode);
 
@@ -48,6 +105,7 @@ class GLSceneView : public QOpenGLWidget, public QOpenGLFunctions
     inline const gl_scene::Vec3& getCursorPosition() const { return mCursorPosition; }
     inline gl_scene::Camera& camera() { return mCamera; }
     inline gl_scene::Manipulator::Ptr getManipulator() const { return mManipulator; }
+    inline const gl_scene::Capabilities& getCapabilities() const { return mCapabilities; }
 
  signals:
     void signalSelectionChanged(const gl_scene::Item::IdPack& item_Ids);
@@ -66,30 +124,140 @@ class GLSceneView : public QOpenGLWidget, public QOpenGLFunctions
     void wheelEvent(QWheelEvent* event) override;
 
  private:
+    struct FrameTimer
+    {
+        std::shared_ptr<QOpenGLTimerQuery> query;
+        bool isStarted{false};
+    };
+
+    struct Viewport
+    {
+        QRectF area;
+        gl_scene::Camera::Ptr camera;
+    };
+
+    struct DrawItem
+    {
+        gl_scene::Item* item;
+        gl_scene::PipeExt* pipe;
+        gl_scene::GeometryData geometry;
+        gl_scene::IndirectPipe* indirectPipe;  // null if the item is drawn by its own call
+        GLuint indirectIndex;                  // the index of the item's data within the indirect pipe
+        const gl_scene::TextureManager::Region* region;
+    };
+
+    // the visible indirect items sharing the state, they are drawn by the single call
+    struct IndirectRun
+    {
+        size_t begin;
+        size_t end;
+        GLsizei first;
+    };
+
+    // the blended item and its center's z in the camera's view space
+    struct TransparentItem
+    {
+        const DrawItem* drawItem;
+        float viewZ;
+    };
+
+    // the uniforms set by the previous paintItem, they aren't set again for the same pipe
+    struct ItemUniforms
+    {
+        gl_scene::Color color;
+        float alfa{0.0f};
+        gl_scene::PipeExt* pipe{nullptr};
+    };
+
     void pickItems(int x1, int y1, int x2, int y2, int mask = 1, bool is_selection = true);
-    void paintItems(bool is_standart_drawing = true);
+    void bindSceneBuffer(const gl_scene::QualityLevel& quality);
+    void resolveSceneBuffer();
+    void beginFrameTimer();
+    void endFrameTimer();
+    void buildDrawList(bool is_standart_drawing = true);
+    void updateBatches();
+    void paintItems(const gl_scene::Camera& camera, bool is_standart_drawing = true);
+    void paintBatches(const gl_scene::Camera& camera, const gl_scene::Light& light, bool is_standart_drawing,
+                      bool is_occlusion_culling);
+    QRect toPixels(const QRectF& area, const QSize& size) const;
+    void resizeViewports();
     void paintTextItems();
-    void paintItem(gl_scene::PipeExt::Ptr pipe, gl_scene::Item::Ptr item, bool is_standart_drawing = true);
+    void paintOverlay();
+    QOpenGLFramebufferObject* resolveDepth();
+    const gl_scene::LabelPlacer::DepthMap& readDepthMap();
+    void paintItem(gl_scene::PipeExt* pipe, const DrawItem& draw_item, bool is_standart_drawing = true);
+    void prepareIndirectRuns();
+    bool isSameRun(const DrawItem& first, const DrawItem& second) const;
+    void sortTransparentItems(const gl_scene::Camera& camera);
+    gl_scene::Color getItemColor(const gl_scene::Item& item, bool is_standart_drawing) const;
+    bool isHighlighted(const gl_scene::Item& item) const;
     void cleanup();
     void setRenderAttributes(const gl_scene::RenderAttributes& attributes);
     void updateCursorShape();
+    void scheduleUpdate();
 
     int mCurX;
     int mCurY;
     int mPressedX;
     int mPressedY;
     bool mIsTextVisible{true};
-    GLSceneGlass* mGlassWidget;
+    bool mIsLabelOcclusion{false};
+    bool mIsSelectionFrameVisible{false};
+    gl_scene::Rect mSelectionRect;
     gl_scene::Camera mCamera{gl_scene::defaults::cameras::kDefault};
+    QRectF mMainViewportArea{0.0, 0.0, 1.0, 1.0};
+    std::vector<Viewport> mViewports;
+    std::vector<DrawItem> mDrawList;
+    std::vector<const DrawItem*> mVisibleItems;
+    std::vector<IndirectRun> mIndirectRuns;
+    size_t mTransparentBegin{0};  // the blended items follow the others in the visible items
+    std::vector<TransparentItem> mTransparentItems;
+    std::map<const gl_scene::Camera*, std::vector<const gl_scene::Item*>> mTransparentOrders;
+    std::unordered_map<const gl_scene::Item*, size_t> mTransparentRanks;
+    ItemUniforms mItemUniforms;
     gl_scene::Manipulator::Ptr mManipulator;
     gl_scene::Mat4 mMVPTransformation;
     gl_scene::Vec3 mPosition{0.0, 0.0, 0.0};
     gl_scene::Vec3 mCursorPosition;
     gl_scene::RenderAttributes mStandartRenderAttributes;
     gl_scene::RenderAttributes mPickingRenderAttributes;
+    gl_scene::RenderAttributes mTextRenderAttributes;
+    gl_scene::RenderAttributes mTransparentRenderAttributes;
     gl_scene::Scene::Ptr mScene;
+    gl_scene::Scene::ListenerID mSceneListenerId{0};
+    gl_scene::Capabilities mCapabilities;
+    gl_scene::ResourceManager::Ptr mResourceManager;
+    gl_scene::TextureManager::Ptr mTextureManager;
+    gl_scene::TextRenderer::Ptr mTextRenderer;
+    gl_scene::OverlayRenderer::Ptr mOverlayRenderer;
+    gl_scene::FrameScheduler mFrameScheduler{[this]() { update(); }};
+    QTimer mSwapTimer;  // ends the frame which isn't swapped (e.g. grabbed or painted while hidden)
+    gl_scene::QualityController mQualityController;
+    std::shared_ptr<QOpenGLFramebufferObject> mSceneBuffer;
+    int mSceneBufferSamples{0};
+    std::array<FrameTimer, 2> mFrameTimers;
+    size_t mFrameTimerIndex{0};
+    gl_scene::LabelPlacer mLabelPlacer;
+    gl_scene::LabelPlacer::DepthMap mDepthMap;
+    std::shared_ptr<QOpenGLFramebufferObject> mDepthBuffer;  // the scene buffer's depth resolved to be read
+    QOpenGLBuffer mDepthMapBuffer{QOpenGLBuffer::PixelPackBuffer};
+    GLsync mDepthMapFence{nullptr};
+    QSize mDepthMapSize;          // the size of the depth map being read back
+    bool mIsDepthMapStale{true};  // the frame rendered after the latest readback isn't read back yet
+    std::vector<gl_scene::StreamingTexture::Ptr> mStreamingTextures;
+    qint64 mUploadBudget{gl_scene::defaults::textures::kUploadBudget};
+    QString mTextureCacheDir;
+    bool mIsTextureCompressed{false};
+    QString mProgramCacheDir;
     gl_scene::PipeExt::Pack mStaticPipes;
     gl_scene::PipeExt::Pack mDynamicPipes;
+    gl_scene::IndirectPipe::Pack mIndirectPipes;
+    gl_scene::BatchPipe::Pack mBatchPipes;               // the pipes of the scene's batches by the batch's index
+    std::vector<gl_scene::Batch::Location> mHiddenSlots;  // the highlighted frozen items drawn by their own calls
+    bool mIsGpuCulling{false};
+    gl_scene::OcclusionCuller mOcclusionCuller;
+    bool mIsOcclusionCulling{false};
+    bool mIsOcclusionStale{true};  // the frame rendered after the latest capture isn't captured yet
     gl_scene::Item::IdPack mSelectedItemIds;
     gl_scene::ItemID mHoveredItemId;
     gl_scene::Color mBackgroundColor{gl_scene::defaults::colors::kSceneBackground};
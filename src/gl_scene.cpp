@@ -1,7 +1,58 @@
 #include "gl_scene.h"
+#include "gl_scene_utility.h"
+#include <algorithm>
+#include <cmath>
+#include <tuple>
 
 using namespace gl_scene;
 
+namespace
+{
+
+// the items of the batch share the pipe, the texture, the render state and the chunk
+struct BatchKey
+{
+    inline bool operator<(const BatchKey& other) const
+    {
+        return std::tie(pipeId, textureId, mode, isPickable, lineWidth, enableAttributes, disableAttributes, chunk) <
+               std::tie(other.pipeId, other.textureId, other.mode, other.isPickable, other.lineWidth,
+                        other.enableAttributes, other.disableAttributes, other.chunk);
+    }
+
+    PipeID pipeId;
+    TextureID textureId;
+    GLenum mode;
+    bool isPickable;
+    float lineWidth;
+    std::vector<GLenum> enableAttributes;
+    std::vector<GLenum> disableAttributes;
+    std::array<int, 3> chunk;
+};
+
+BatchKey toKey(const Batch& batch)
+{
+    const auto& parameters = batch.renderParameters;
+    return {batch.pipeId,
+            batch.textureId,
+            parameters.mode,
+            batch.isPickable,
+            parameters.attributes.lineWidth,
+            parameters.attributes.enableAttributes,
+            parameters.attributes.disableAttributes,
+            batch.chunk};
+}
+
+// the primitives of the merged strips and fans would be joined, so only the lists are merged, the mutable geometry
+// is changed in place, so it isn't baked
+bool isFreezable(const Item& item)
+{
+    const auto& mode = item.renderParameters.mode;
+    return item.isVisible && !item.isMutableGeometry && !item.texture && item.renderParameters.alfa >= 1.0f &&
+           (mode == GL_TRIANGLES || mode == GL_LINES);
+}
+
+}  // namespace
+
 Scene::Scene(const Mesh::Map& mesh_map, const Light& light, const Shader::Map& shader_map,
              const TexturesMap& textures_map) :
     mMeshMap(mesh_map),
@@ -14,15 +65,33 @@ Scene::Scene(const Mesh::Map& mesh_map, const Light& light, const Shader::Map& s
 
 void Scene::initialize()
 {
-    int index{0};
+    GLint index{0};
+    GLint indexFirst{0};
     for (const auto& meshPair : mMeshMap)
     {
-        const auto& meshID       = meshPair.first;
-        const auto& meshVertices = meshPair.second.getVertices();
+        const auto& meshID = meshPair.first;
+        const auto& mesh   = meshPair.second;
+        const auto& count  = static_cast<GLsizei>(mesh.getVertexCount());
+
+        // meshes' data is uploaded straight from its storage, the scene keeps the references only
+        mVertexSegments.push_back({mesh.getVertexData(), count * static_cast<int>(sizeof(Vertex))});
+
+        if (mesh.isIndexed())
+        {
+            const auto& indexCount = static_cast<GLsizei>(mesh.getIndexCount());
+            mIndexSegments.push_back({mesh.getIndexData(), indexCount * static_cast<int>(sizeof(GLuint))});
+            mMeshGeometryMap[meshID] = {indexFirst, indexCount, true, index};
+            indexFirst += indexCount;
+        }
+        else
+        {
+            mMeshGeometryMap[meshID] = {index, count};
+        }
+
+        // the bounds are used for the culling
+        auto& geometryData = mMeshGeometryMap[meshID];
+        calculateBounds(mesh.getVertexData(), mesh.getVertexCount(), geometryData.min, geometryData.max);
 
-        std::copy(meshVertices.begin(), meshVertices.end(), std::back_inserter(mVertices));
-        GLsizei count            = static_cast<GLsizei>(meshVertices.size());
-        mMeshGeometryMap[meshID] = {index, count};
         index += count;
     }
 }
@@ -38,6 +107,7 @@ Item::Ptr Scene::addItem(const Item& item)
 void Scene::addItem(const Item::Ptr& item_ptr)
 {
     mItemPtrMap[item_ptr->pipeId].emplace_back(item_ptr);
+    notifyChanged();
 }
 
 void Scene::addObject(const SceneObject::Ptr& obj_ptr)
@@ -59,6 +129,192 @@ void Scene::update()
             obj->update();
         }
     }
+
+    notifyChanged();
+}
+
+size_t Scene::freeze()
+{
+    // the items go to the batches with the same key, the thawed slots are reclaimed by the compaction (see thaw)
+    std::map<BatchKey, size_t> batchIndexes;
+    for (size_t index{0}; index < mBatches.size(); ++index)
+    {
+        batchIndexes.emplace(toKey(mBatches[index]), index);
+    }
+
+    const auto revision = mBatchRevision + 1;
+    size_t frozenCount{0};
+    for (const auto& itemsPair : mItemPtrMap)
+    {
+        for (const auto& item : itemsPair.second)
+        {
+            if (!isFreezable(*item) || mFrozenItems.count(item.get()))
+            {
+                continue;
+            }
+
+            const auto meshPair = mMeshMap.find(item->meshId);
+            if (meshPair == mMeshMap.cend())
+            {
+                continue;
+            }
+
+            const auto& mesh     = meshPair->second;
+            const auto& geometry = getGeometryData(item->meshId);
+            const auto* vertices = mesh.getVertexData();
+            const auto* indices  = mesh.isIndexed() ? mesh.getIndexData() : nullptr;
+            const auto& count    = mesh.isIndexed() ? mesh.getIndexCount() : mesh.getVertexCount();
+            auto min             = geometry.min;
+            auto max             = geometry.max;
+
+            if (count == 0)
+            {
+                continue;
+            }
+
+            // the item goes to the chunk of its bounds' center
+            transformBounds(item->transformation, min, max);
+            const auto& center = (min + max) * (0.5f / defaults::batches::kChunkSize);
+            const Batch header{item->pipeId,
+                               item->textureId,
+                               item->renderParameters,
+                               item->id != 0,
+                               {static_cast<int>(std::floor(center.x())), static_cast<int>(std::floor(center.y())),
+                                static_cast<int>(std::floor(center.z()))}};
+
+            const auto& batchPair = batchIndexes.emplace(toKey(header), mBatches.size());
+            if (batchPair.second)
+            {
+                mBatches.push_back(header);
+            }
+
+            auto& batch              = mBatches[batchPair.first->second];
+            mFrozenItems[item.get()] = {batchPair.first->second, batch.slots.size()};
+            batch.append(*item, vertices, indices, count, revision);
+            frozenCount++;
+        }
+    }
+
+    if (frozenCount > 0)
+    {
+        mBatchRevision = revision;
+        notifyChanged();
+    }
+
+    return frozenCount;
+}
+
+bool Scene::thaw(const Item& item)
+{
+    const auto locationPair = mFrozenItems.find(&item);
+    if (locationPair == mFrozenItems.cend())
+    {
+        return false;
+    }
+
+    const auto location = locationPair->second;
+    auto& batch         = mBatches[location.batch];
+    batch.collapse(location.slot, ++mBatchRevision);
+    mFrozenItems.erase(locationPair);
+
+    // the collapsed vertices are still drawn, so the batch is rebuilt once they're the most of it
+    if (static_cast<float>(batch.frozenCount) <
+        static_cast<float>(batch.slots.size()) * defaults::batches::kMinFrozenShare)
+    {
+        batch.compact(mBatchRevision);
+        for (size_t slot{0}; slot < batch.slots.size(); ++slot)
+        {
+            mFrozenItems[batch.slots[slot].item] = {location.batch, slot};
+        }
+    }
+
+    notifyChanged();
+
+    return true;
+}
+
+TextItemID Scene::addTextItem(const TextItem& item)
+{
+    const auto textItemId        = mNextTextItemId++;
+    mTextItemIndexes[textItemId] = mTextItemPack.size();
+    mTextItemPack.push_back(item);
+    mTextItemRevisions.push_back(++mTextItemRevision);
+    mTextItemIds.push_back(textItemId);
+    notifyChanged();
+
+    return textItemId;
+}
+
+bool Scene::updateTextItem(TextItemID text_item_id, const TextItem& item)
+{
+    const auto indexPair = mTextItemIndexes.find(text_item_id);
+    if (indexPair == mTextItemIndexes.cend())
+    {
+        return false;
+    }
+
+    mTextItemPack[indexPair->second]      = item;
+    mTextItemRevisions[indexPair->second] = ++mTextItemRevision;
+    notifyChanged();
+
+    return true;
+}
+
+bool Scene::moveTextItem(TextItemID text_item_id, const Vec3& position)
+{
+    const auto indexPair = mTextItemIndexes.find(text_item_id);
+    if (indexPair == mTextItemIndexes.cend())
+    {
+        return false;
+    }
+
+    // the anchor is projected every frame anyway, so the revision stays and the layout is reused
+    mTextItemPack[indexPair->second].position = position;
+    notifyChanged();
+
+    return true;
+}
+
+bool Scene::removeTextItem(TextItemID text_item_id)
+{
+    const auto indexPair = mTextItemIndexes.find(text_item_id);
+    if (indexPair == mTextItemIndexes.cend())
+    {
+        return false;
+    }
+
+    // the last item takes the place of the removed one, its slot gets the new revision
+    const auto index = indexPair->second;
+    mTextItemIndexes.erase(indexPair);
+    if (index + 1 != mTextItemPack.size())
+    {
+        mTextItemPack[index]                  = std::move(mTextItemPack.back());
+        mTextItemRevisions[index]             = ++mTextItemRevision;
+        mTextItemIds[index]                   = mTextItemIds.back();
+        mTextItemIndexes[mTextItemIds[index]] = index;
+    }
+
+    mTextItemPack.pop_back();
+    mTextItemRevisions.pop_back();
+    mTextItemIds.pop_back();
+    notifyChanged();
+
+    return true;
+}
+
+void Scene::setTextItems(const TextItem::Pack& items)
+{
+    mTextItemPack.clear();
+    mTextItemRevisions.clear();
+    mTextItemIds.clear();
+    mTextItemIndexes.clear();
+
+    for (const auto& item : items)
+    {
+        addTextItem(item);
+    }
+
+    notifyChanged();
 }
 
 GeometryData Scene::getGeometryData(MeshID mesh_id) const
@@ -72,23 +328,34 @@ GeometryData Scene::getGeometryData(MeshID mesh_id) const
     return {};
 }
 
-Texture::Ptr Scene::getTexture(TextureID texture_id)
+const Batch::Location* Scene::findFrozen(const Item& item) const
 {
-    auto texturePtr = mTexturesMap.find(texture_id);
-    if (texturePtr != mTexturesMap.end())
-    {
-        auto& texture = texturePtr->second;
-        if (!texture.data)
-        {
-            auto data = std::make_shared<QOpenGLTexture>(QImage(texture.filename).mirrored());
-            data->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-            data->setMagnificationFilter(QOpenGLTexture::Linear);
+    const auto locationPair = mFrozenItems.find(&item);
+    return locationPair != mFrozenItems.cend() ? &locationPair->second : nullptr;
+}
 
-            texture.data = data;
-        }
+Scene::ListenerID Scene::addChangedListener(const ChangedCallback& callback)
+{
+    const auto listenerId = mNextListenerId++;
+    mChangedListeners.emplace_back(listenerId, callback);
 
-        return texture.data;
+    return listenerId;
+}
+
+void Scene::removeChangedListener(ListenerID listener_id)
+{
+    const auto listener = std::find_if(mChangedListeners.cbegin(), mChangedListeners.cend(),
+                                       [listener_id](const auto& pair) { return pair.first == listener_id; });
+    if (listener != mChangedListeners.cend())
+    {
+        mChangedListeners.erase(listener);
     }
+}
 
-    return {};
+void Scene::notifyChanged()
+{
+    for (const auto& listener : mChangedListeners)
+    {
+        listener.second();
+    }
 }
@@ -0,0 +1,101 @@
+#include "gl_scene_batch.h"
+#include <algorithm>
+#include <limits>
+
+using namespace gl_scene;
+
+void Batch::append(const Item& item, const gl_scene::Vertex* item_vertices, const GLuint* indices, size_t count,
+                   uint64_t freeze_revision)
+{
+    const auto& model        = item.transformation;
+    const auto& normalMatrix = model.normalMatrix();
+    const Color idColor(item.id);
+    const std::array<float, 4> color{static_cast<float>(item.color.redF()), static_cast<float>(item.color.greenF()),
+                                     static_cast<float>(item.color.blueF()), 1.0f};
+    const std::array<float, 4> itemId{static_cast<float>(idColor.redF()), static_cast<float>(idColor.greenF()),
+                                      static_cast<float>(idColor.blueF()), 1.0f};
+
+    if (slots.empty())
+    {
+        min = Vec3{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                   std::numeric_limits<float>::max()};
+        max = -min;
+    }
+
+    slots.push_back({&item, static_cast<GLint>(vertices.size()), static_cast<GLsizei>(count), freeze_revision});
+    frozenCount++;
+    revision       = freeze_revision;
+    layoutRevision = freeze_revision;
+    vertices.reserve(vertices.size() + count);
+    for (size_t index{0}; index < count; ++index)
+    {
+        const auto& vertex   = item_vertices[indices != nullptr ? indices[index] : index];
+        const auto& position = model.map(Vec3{vertex[0], vertex[1], vertex[2]});
+        Vec3 normal;
+        for (int row{0}; row < 3; ++row)
+        {
+            normal[row] = normalMatrix(row, 0) * vertex[3] + normalMatrix(row, 1) * vertex[4] +
+                          normalMatrix(row, 2) * vertex[5];
+        }
+
+        vertices.push_back({position.x(), position.y(), position.z(), normal.x(), normal.y(), normal.z(), vertex[6],
+                            vertex[7], color[0], color[1], color[2], color[3], itemId[0], itemId[1], itemId[2],
+                            itemId[3]});
+
+        for (int axis{0}; axis < 3; ++axis)
+        {
+            min[axis] = std::min(min[axis], position[axis]);
+            max[axis] = std::max(max[axis], position[axis]);
+        }
+    }
+}
+
+void Batch::collapse(size_t slot, uint64_t thaw_revision)
+{
+    auto& batchSlot = slots[slot];
+    auto* first     = vertices.data() + batchSlot.first;
+    for (auto* vertex = first; vertex != first + batchSlot.count; ++vertex)
+    {
+        std::copy(first->cbegin(), first->cbegin() + 3, vertex->begin());
+    }
+
+    batchSlot.item     = nullptr;
+    batchSlot.revision = thaw_revision;
+    revision           = thaw_revision;
+    frozenCount--;
+}
+
+void Batch::compact(uint64_t compact_revision)
+{
+    // the kept vertices are moved to the front in place, the slots keep their order
+    GLint first{0};
+    size_t kept{0};
+    for (const auto& slot : slots)
+    {
+        if (slot.item == nullptr)
+        {
+            continue;
+        }
+
+        const auto& source = vertices.cbegin() + slot.first;
+        std::copy(source, source + slot.count, vertices.begin() + first);
+        slots[kept++] = {slot.item, first, slot.count, compact_revision};
+        first += slot.count;
+    }
+
+    slots.resize(kept);
+    vertices.resize(static_cast<size_t>(first));
+    min = Vec3{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    max = -min;
+    for (const auto& vertex : vertices)
+    {
+        for (int axis{0}; axis < 3; ++axis)
+        {
+            min[axis] = std::min(min[axis], vertex[static_cast<size_t>(axis)]);
+            max[axis] = std::max(max[axis], vertex[static_cast<size_t>(axis)]);
+        }
+    }
+
+    revision       = compact_revision;
+    layoutRevision = compact_revision;
+}
@@ -223,8 +223,9 @@ void Camera::update(bool use_angles, bool update_look)
     }
 
     mProjectionOrtho.setScale(mScale);
+    calculateState();
 
-    emit signalChanged(getTransformation());
+    emit signalChanged(mState.transformation);
 }
 
 void Camera::calculateViewMatrix()
@@ -232,6 +233,13 @@ void Camera::calculateViewMatrix()
     mViewMatrix.setToIdentity();
     mViewMatrix.lookAt(mPosition, mPosition + mFront, mUp);
     mViewMatrix.scale(mZoom);
+    calculateState();
+}
+
+void Camera::calculateState()
+{
+    // the matrices are used by every projection of the frame, so they are calculated once per camera change
+    mState = CameraState::make(mViewMatrix, getProjection(), mPosition, {mViewPortSize.first, mViewPortSize.second});
 }
 
 void Camera::checkRangeLimits()
@@ -293,63 +301,84 @@ void Camera::setPosition(const Vec3& position)
 
 Vec3 Camera::toWorldXYCoordinates(int screen_x, int screen_y, float world_z) const
 {
-    Vec3 worldNear = toWorldCoordinates(screen_x, screen_y, 0.0f);
-    Vec3 worldFar  = toWorldCoordinates(screen_x, screen_y, 1.0f);
-
-    if (worldFar.z() > worldNear.z() - 0.001f)
-    {
-        worldFar.setZ(worldNear.z() - 0.001f);
-    }
-
-    auto worldDir = worldFar - worldNear;
-    float res     = !qFuzzyIsNull(worldDir.z()) ? (world_z - worldNear.z()) / worldDir.z() : world_z - worldNear.z();
+    const float screenPoint[2]{static_cast<float>(screen_x), static_cast<float>(screen_y)};
+    float worldPoint[3];
+    toWorldXYCoordinates(screenPoint, 1, worldPoint, world_z);
 
-    auto worldX = !qFuzzyIsNull(worldDir.x()) ? res * worldDir.x() + worldNear.x() : res + worldNear.x();
-    auto worldY = !qFuzzyIsNull(worldDir.y()) ? res * worldDir.y() + worldNear.y() : res + worldNear.y();
-    auto worldZ = world_z;
-
-    Vec3 pos = {worldX, worldY, worldZ};
-
-    return pos;
+    return {worldPoint[0], worldPoint[1], worldPoint[2]};
 }
 
 Point3Pack Camera::toWorldXYCoordinates(const Point2Pack& screen_points, float world_z) const
 {
-    Point3Pack points;
+    if (screen_points.empty())
+    {
+        return {};
+    }
+
+    std::vector<float> screenPoints;
+    screenPoints.reserve(screen_points.size() * 2);
     for (const auto& point : screen_points)
     {
-        points.push_back(gl_scene::toPoint3(toWorldXYCoordinates(point.first, point.second, world_z)));
+        screenPoints.insert(screenPoints.end(), {point.first, point.second});
     }
+
+    Point3Pack points(screen_points.size());
+    toWorldXYCoordinates(screenPoints.data(), screen_points.size(), points.data()->data(), world_z);
+
     return points;
 }
 
+void Camera::toWorldXYCoordinates(const float* screen_points, size_t count, float* world_points, float world_z) const
+{
+    mState.toWorldXYCoordinates(screen_points, count, world_points, world_z);
+}
+
 Vec3 Camera::toWorldCoordinates(int screen_x, int screen_y, float distance) const
 {
-    int screenW = mViewPortSize.first;
-    int screenH = mViewPortSize.second;
-    Vec3 screenNear(screen_x, screenH - screen_y, distance);
+    const float screenPoint[2]{static_cast<float>(screen_x), static_cast<float>(screen_y)};
+    float worldPoint[3];
+    toWorldCoordinates(screenPoint, 1, worldPoint, distance);
 
-    return screenNear.unproject(getView(), getProjection(), QRect(0, 0, screenW, screenH));
+    return {worldPoint[0], worldPoint[1], worldPoint[2]};
 }
 
 Point3Pack Camera::toWorldCoordinates(const Point2Pack& screen_points, float distance) const
 {
-    Point3Pack points;
+    if (screen_points.empty())
+    {
+        return {};
+    }
+
+    std::vector<float> screenPoints;
+    screenPoints.reserve(screen_points.size() * 2);
     for (const auto& point : screen_points)
     {
-        points.push_back(gl_scene::toPoint3(toWorldCoordinates(point.first, point.second, distance)));
+        screenPoints.insert(screenPoints.end(), {point.first, point.second});
     }
 
+    Point3Pack points(screen_points.size());
+    toWorldCoordinates(screenPoints.data(), screen_points.size(), points.data()->data(), distance);
+
     return points;
 }
 
+void Camera::toWorldCoordinates(const float* screen_points, size_t count, float* world_points, float distance) const
+{
+    mState.toWorldCoordinates(screen_points, count, world_points, distance);
+}
+
 Vec2 Camera::toScreenCoordinates(const Vec3& world_point) const
 {
-    const auto& position = getTransformation() * QVector4D(world_point, 1.0);
+    const auto& position = mState.transformation * QVector4D(world_point, 1.0);
 
     return {position.x(), position.y()};
 }
 
+void Camera::toScreenPixels(const float* world_points, size_t count, float* screen_points) const
+{
+    mState.toScreenPixels(world_points, count, screen_points);
+}
+
 void Camera::resetTo(const Camera& camera)
 {
     float orthoRatio       = this->mProjectionOrtho.getRatio();
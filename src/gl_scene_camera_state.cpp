@@ -0,0 +1,134 @@
+#include "gl_scene_camera_state.h"
+#include "gl_scene_utility.h"
+
+using namespace gl_scene;
+
+namespace
+{
+
+// the same mapping as QVector3D::unproject does for the viewport with the flipped y
+void toNdc(const QSize& viewport, const float* screen_points, size_t count, float distance, float* ndc_points)
+{
+    const auto& width  = static_cast<float>(viewport.width());
+    const auto& height = static_cast<float>(viewport.height());
+    for (size_t index{0}; index < count; ++index)
+    {
+        ndc_points[index * 3]     = screen_points[index * 2] / width * 2.0f - 1.0f;
+        ndc_points[index * 3 + 1] = (height - screen_points[index * 2 + 1]) / height * 2.0f - 1.0f;
+        ndc_points[index * 3 + 2] = distance * 2.0f - 1.0f;
+    }
+}
+
+}  // namespace
+
+CameraState CameraState::make(const Mat4& view, const Mat4& projection, const Vec3& position, const QSize& viewport)
+{
+    CameraState state;
+    state.view                  = view;
+    state.projection            = projection;
+    state.transformation        = projection * view;
+    state.inverseTransformation = state.transformation.inverted();
+    state.position              = position;
+    state.viewport              = viewport;
+
+    // the planes are extracted from the rows of the transformation matrix
+    const auto& m = state.transformation;
+    for (int row{0}; row < 3; ++row)
+    {
+        state.frustum[static_cast<size_t>(row * 2)]     = m.row(3) + m.row(row);
+        state.frustum[static_cast<size_t>(row * 2 + 1)] = m.row(3) - m.row(row);
+    }
+
+    for (auto& plane : state.frustum)
+    {
+        const auto& length = plane.toVector3D().length();
+        plane              = qFuzzyIsNull(length) ? plane : plane / length;
+    }
+
+    return state;
+}
+
+void CameraState::toWorldCoordinates(const float* screen_points, size_t count, float* world_points,
+                                     float distance) const
+{
+    toNdc(viewport, screen_points, count, distance, world_points);
+    transformPoints(inverseTransformation, world_points, count, world_points);
+}
+
+void CameraState::toWorldXYCoordinates(const float* screen_points, size_t count, float* world_points,
+                                       float world_z) const
+{
+    // the near and the far points of each screen point go in pairs
+    std::vector<float> worldPoints(count * 6);
+    for (size_t index{0}; index < count; ++index)
+    {
+        toNdc(viewport, screen_points + index * 2, 1, 0.0f, worldPoints.data() + index * 6);
+        toNdc(viewport, screen_points + index * 2, 1, 1.0f, worldPoints.data() + index * 6 + 3);
+    }
+
+    transformPoints(inverseTransformation, worldPoints.data(), count * 2, worldPoints.data());
+
+    for (size_t index{0}; index < count; ++index)
+    {
+        const auto* points = worldPoints.data() + index * 6;
+        Vec3 worldNear{points[0], points[1], points[2]};
+        Vec3 worldFar{points[3], points[4], points[5]};
+
+        if (worldFar.z() > worldNear.z() - 0.001f)
+        {
+            worldFar.setZ(worldNear.z() - 0.001f);
+        }
+
+        const auto& worldDir = worldFar - worldNear;
+        const auto& deltaZ   = world_z - worldNear.z();
+        const auto& res      = !qFuzzyIsNull(worldDir.z()) ? deltaZ / worldDir.z() : deltaZ;
+
+        auto* worldPoint = world_points + index * 3;
+        worldPoint[0]    = !qFuzzyIsNull(worldDir.x()) ? res * worldDir.x() + worldNear.x() : res + worldNear.x();
+        worldPoint[1]    = !qFuzzyIsNull(worldDir.y()) ? res * worldDir.y() + worldNear.y() : res + worldNear.y();
+        worldPoint[2]    = world_z;
+    }
+}
+
+void CameraState::toScreenPixels(const float* world_points, size_t count, float* screen_points) const
+{
+    std::vector<float> ndcPoints(count * 3);
+    transformPoints(transformation, world_points, count, ndcPoints.data());
+
+    const auto& width  = static_cast<float>(viewport.width());
+    const auto& height = static_cast<float>(viewport.height());
+    for (size_t index{0}; index < count; ++index)
+    {
+        screen_points[index * 2]     = (ndcPoints[index * 3] + 1.0f) * 0.5f * width;
+        screen_points[index * 2 + 1] = height - (ndcPoints[index * 3 + 1] + 1.0f) * 0.5f * height;
+    }
+}
+
+bool CameraState::isVisible(const Vec3& center, float radius) const
+{
+    for (const auto& plane : frustum)
+    {
+        if (QVector3D::dotProduct(plane.toVector3D(), center) + plane.w() < -radius)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CameraState::isVisible(const Vec3& min, const Vec3& max) const
+{
+    // the box is outside if its corner farthest along the plane's normal is behind the plane
+    for (const auto& plane : frustum)
+    {
+        const Vec3 corner{plane.x() >= 0.0f ? max.x() : min.x(), plane.y() >= 0.0f ? max.y() : min.y(),
+                          plane.z() >= 0.0f ? max.z() : min.z()};
+        if (QVector3D::dotProduct(plane.toVector3D(), corner) + plane.w() < 0.0f)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,152 @@
+#include "gl_scene_capabilities.h"
+#include <QOpenGLFunctions>
+#include <QStringList>
+#include <algorithm>
+
+using namespace gl_scene;
+
+namespace
+{
+
+const GLenum kNumProgramBinaryFormats{0x87FE};
+
+bool isVersion(const Capabilities& capabilities, int major, int minor)
+{
+    const auto& version = capabilities.majorVersion * 10 + capabilities.minorVersion;
+    return major > 0 && version >= major * 10 + minor;
+}
+
+}  // namespace
+
+Capabilities Capabilities::detect()
+{
+    Capabilities capabilities;
+    auto* context = QOpenGLContext::currentContext();
+    if (context == nullptr)
+    {
+        return capabilities;
+    }
+
+    const auto& version       = context->format().version();
+    capabilities.majorVersion = version.first;
+    capabilities.minorVersion = version.second;
+    capabilities.isES         = context->isOpenGLES();
+
+    // the features are either the core ones of the version (0 if it's not the core one of the ES) or the extensions
+    const auto& isFeature = [&](int major, int minor, int es_major, int es_minor, const char* extension) {
+        const auto& isCore = capabilities.isES ? isVersion(capabilities, es_major, es_minor) :
+                                                 isVersion(capabilities, major, minor);
+        return isCore || context->hasExtension(extension);
+    };
+
+    capabilities.isBaseVertex        = isFeature(3, 2, 3, 2, "GL_ARB_draw_elements_base_vertex");
+    capabilities.isInstancing        = isFeature(3, 3, 3, 0, "GL_ARB_instanced_arrays");
+    capabilities.isMultiDrawIndirect = isFeature(4, 3, 0, 0, "GL_ARB_multi_draw_indirect");
+    capabilities.isIndirectCount     = isFeature(4, 6, 0, 0, "GL_ARB_indirect_parameters");
+    capabilities.isBufferStorage     = isFeature(4, 4, 0, 0, "GL_ARB_buffer_storage");
+    capabilities.isUniformBuffer     = isFeature(3, 1, 3, 0, "GL_ARB_uniform_buffer_object");
+    capabilities.isCompute           = isFeature(4, 3, 3, 1, "GL_ARB_compute_shader");
+    capabilities.isTimerQuery        = isFeature(3, 3, 0, 0, "GL_ARB_timer_query");
+    capabilities.isParallelCompile   = context->hasExtension("GL_KHR_parallel_shader_compile");
+
+    GLint formatCount{0};
+    context->functions()->glGetIntegerv(kNumProgramBinaryFormats, &formatCount);
+    capabilities.isProgramBinary = formatCount > 0;
+
+    if (capabilities.isMultiDrawIndirect && capabilities.isCompute)
+    {
+        capabilities.tier = Tier::kModern;
+    }
+    else if (capabilities.isInstancing && isVersion(capabilities, 3, 3) && !capabilities.isES)
+    {
+        capabilities.tier = Tier::kCore;
+    }
+    else
+    {
+        capabilities.tier = Tier::kLegacy;
+    }
+
+    return capabilities;
+}
+
+std::string Capabilities::toShaderSource(const std::string& source, const std::string& defines) const
+{
+    if (source.compare(0, 8, "#version") == 0)
+    {
+        const auto& headerEnd = std::min(source.find('\n'), source.size() - 1) + 1;
+        return source.substr(0, headerEnd) + defines + source.substr(headerEnd);
+    }
+
+    std::string header;
+    if (isES)
+    {
+        header = "#version 300 es\nprecision highp float;\nprecision highp int;\nprecision highp sampler2DArray;\n";
+    }
+    else if (isVersion(*this, 3, 3))
+    {
+        header = "#version " + std::to_string(majorVersion * 100 + minorVersion * 10) + " core\n";
+    }
+    else
+    {
+        // GLSL 1.30 - 1.50 go with the OpenGL 3.0 - 3.2, the attribute locations are given by the extension, the older
+        // contexts aren't supported (see isSupported), their header is clamped to the lowest version
+        const auto& minor = isSupported() ? std::min(std::max(minorVersion, 0), 2) : 0;
+        header            = "#version " + std::to_string(130 + minor * 10) +
+                            "\n#extension GL_ARB_explicit_attrib_location : enable\n";
+    }
+
+    return header + defines + source;
+}
+
+QString Capabilities::toString() const
+{
+    static const char* kTierNames[]{"legacy", "core", "modern"};
+
+    const std::pair<bool, const char*> featureFlags[]{{isBaseVertex, "base vertex"},
+                                                   {isInstancing, "instancing"},
+                                                   {isMultiDrawIndirect, "multi-draw indirect"},
+                                                   {isIndirectCount, "indirect count"},
+                                                   {isBufferStorage, "buffer storage"},
+                                                   {isUniformBuffer, "uniform buffers"},
+                                                   {isCompute, "compute"},
+                                                   {isTimerQuery, "timer queries"},
+                                                   {isProgramBinary, "program binaries"},
+                                                   {isParallelCompile, "parallel compile"}};
+
+    QStringList features;
+    for (const auto& feature : featureFlags)
+    {
+        if (feature.first)
+        {
+            features << feature.second;
+        }
+    }
+
+    // the paths are described once the renderer has chosen them
+    QString tierName(kTierNames[static_cast<int>(tier)]);
+    if (paths.isChosen)
+    {
+        const QStringList pathNames{paths.isIndirect ? "multi-draw indirect" : "single draws",
+                                    paths.isGpuCulling ? "compute culling" : "CPU culling",
+                                    paths.isBaseVertex ? "base vertex" : "shifted attributes",
+                                    paths.isIndirectLinked ? "indirect programs linked" : "indirect programs failed"};
+        tierName += " (" + pathNames.join(", ") + ")";
+    }
+
+    return QString("OpenGL%1 %2.%3, %4: %5")
+        .arg(isES ? " ES" : "")
+        .arg(majorVersion)
+        .arg(minorVersion)
+        .arg(tierName)
+        .arg(features.join(", "));
+}
+
+void Capabilities::choosePaths(const RenderPaths& chosen_paths)
+{
+    paths          = chosen_paths;
+    paths.isChosen = true;
+    if (tier == Tier::kModern && !paths.isIndirect)
+    {
+        tier = isInstancing && isVersion(*this, 3, 3) && !isES ? Tier::kCore : Tier::kLegacy;
+    }
+}
@@ -97,91 +97,96 @@ const PipeID k3DTexturedLast{9};
 const PipeID k2DTexturedLast{10};
 }  // namespace id
 
+// position, normal and texture coordinates of the Vertex
+const Pipe::Attributes kAttributes{{3, 8, 0}, {3, 8, 3}, {2, 8, 6}};
+
+// screen position, texture coordinates and color of the text Vertex
+const Pipe::Attributes kTextAttributes{{2, 8, 0}, {2, 8, 2}, {4, 8, 4}};
+
+// screen position and color of the overlay vertex
+const Pipe::Attributes kOverlayAttributes{{2, 6, 0}, {4, 6, 2}};
 }  // namespace pipes
 
 namespace shaders
 {
 
-// TO DO
-// Implement the openGL version identification in runtime
+// the shaders go without the version header, it's prepended by the context's capabilities (Capabilities)
 // clang-format off
 
-#define OPENGL_VERSION_3_0  30
-#define OPENGL_VERSION_3_1  31
-#define OPENGL_VERSION_3_2  32
-#define OPENGL_VERSION_3_3  33
-#define OPENGL_VERSION_4_0  40
-#define OPENGL_VERSION_4_1  41
-#define OPENGL_VERSION_4_2  42
-#define OPENGL_VERSION_4_3  43
-#define OPENGL_VERSION_4_4  44
-#define OPENGL_VERSION_4_5  45
-#define OPENGL_VERSION_4_6  46
-
-#define OPENGL_VERSION OPENGL_VERSION_3_3
-
-#if(OPENGL_VERSION == OPENGL_VERSION_3_0)
-#define SHADER_VERSION "#version 130\n#extension GL_ARB_explicit_attrib_location : enable\n"
-#endif
-
-#if(OPENGL_VERSION == OPENGL_VERSION_3_1)
-#define SHADER_VERSION "#version 140\n#extension GL_ARB_explicit_attrib_location : enable\n"
-#endif
-
-#if(OPENGL_VERSION == OPENGL_VERSION_3_2)
-#define SHADER_VERSION "#version 150\n#extension GL_ARB_explicit_attrib_location : enable\n"
-#endif
-
-#if(OPENGL_VERSION == OPENGL_VERSION_3_3)
-#define SHADER_VERSION "#version 330 core\n"
-#endif
-
-#if(OPENGL_VERSION == OPENGL_VERSION_4_0)
-#define SHADER_VERSION "#version 400 core\n"
-#endif
-
-#if(OPENGL_VERSION == OPENGL_VERSION_4_1)
-#define SHADER_VERSION "#version 410 core\n"
-#endif
-
-#if(OPENGL_VERSION == OPENGL_VERSION_4_2)
-#define SHADER_VERSION "#version 420 core\n"
-#endif
-
-#if(OPENGL_VERSION == OPENGL_VERSION_4_3)
-#define SHADER_VERSION "#version 430 core\n"
-#endif
-
-#if(OPENGL_VERSION == OPENGL_VERSION_4_4)
-#define SHADER_VERSION "#version 440 core\n"
-#endif
-
-#if(OPENGL_VERSION == OPENGL_VERSION_4_5)
-#define SHADER_VERSION "#version 450 core\n"
-#endif
-
-#if(OPENGL_VERSION == OPENGL_VERSION_4_6)
-#define SHADER_VERSION "#version 460 core\n"
-#endif
+// the item's data are either the uniforms or the per draw attributes of the indirect draws (SCENE_INDIRECT is defined
+// for them, see IndirectPipe), the draw's attributes are picked by the base instance. The selection pipe takes the
+// item's ID color instead of the material one.
+#define SHADER_ITEM_VERTEX \
+    "#ifdef SCENE_INDIRECT\n\
+    layout (location = 3) in mat4 aModel;\n\
+    layout (location = 7) in mat3 aNormalMatrix;\n\
+    layout (location = 10) in vec4 aColor;\n\
+    layout (location = 11) in vec4 aAtlasRect;\n\
+    layout (location = 12) in float aAtlasLayer;\n\
+    layout (location = 13) in vec4 aIdColor;\n\
+    flat out vec4 ItemColor;\n\
+    flat out vec4 ItemAtlasRect;\n\
+    flat out int ItemAtlasLayer;\n\
+    #ifdef SCENE_SELECTION\n\
+    #define ITEM_COLOR aIdColor\n\
+    #else\n\
+    #define ITEM_COLOR aColor\n\
+    #endif\n\
+    #define model aModel\n\
+    #define normal aNormalMatrix\n\
+    #define ITEM_OUTPUT ItemColor = ITEM_COLOR; ItemAtlasRect = aAtlasRect; ItemAtlasLayer = int(aAtlasLayer);\n\
+    #else\n\
+    uniform mat3 normal;\n\
+    uniform mat4 model;\n\
+    #define ITEM_OUTPUT\n\
+    #endif\n"
+
+#define SHADER_ITEM_FRAGMENT \
+    "#ifdef SCENE_INDIRECT\n\
+    flat in vec4 ItemColor;\n\
+    #define color ItemColor.rgb\n\
+    #define alfa ItemColor.a\n\
+    #else\n\
+    uniform vec3 color;\n\
+    uniform float alfa;\n\
+    #endif\n"
+
+// the texture is sampled either from the standalone texture or from the layer of the texture array (atlas)
+#define SHADER_TEXTURE \
+    "uniform sampler2D textureData;\n\
+    uniform sampler2DArray textureAtlas;\n\
+    #ifdef SCENE_INDIRECT\n\
+    flat in vec4 ItemAtlasRect;\n\
+    flat in int ItemAtlasLayer;\n\
+    #define atlasRect ItemAtlasRect\n\
+    #define atlasLayer ItemAtlasLayer\n\
+    #else\n\
+    uniform int atlasLayer;\n\
+    uniform vec4 atlasRect;\n\
+    #endif\n\
+    vec4 textureColor(vec2 coord)\n\
+    {\n\
+        if (atlasLayer < 0)\n\
+            return texture(textureData, coord);\n\
+        return texture(textureAtlas, vec3(atlasRect.xy + clamp(coord, 0.0, 1.0) * atlasRect.zw, float(atlasLayer)));\n\
+    }\n"
 
 const Shader k3DPipe{
-    SHADER_VERSION
     "layout (location = 0) in vec3 aPos;\n\
     layout (location = 1) in vec3 aNormal;\n\
     out vec3 Normal;\n\
-    out vec3 FragPos;\n\
-    uniform mat3 normal;\n\
-    uniform mat4 model;\n\
-    uniform mat4 view;\n\
+    out vec3 FragPos;\n"
+    SHADER_ITEM_VERTEX
+    "uniform mat4 view;\n\
     uniform mat4 projection;\n\
     void main()\n\
     {\n\
         gl_Position = projection * view * model * vec4(aPos, 1.0);\n\
         FragPos = vec3(model * vec4(aPos, 1.0));\n\
         Normal = normal * aNormal;\n\
+        ITEM_OUTPUT\n\
     }",
 
-    SHADER_VERSION
     "struct Light {\n\
         vec3 direction;\n\
         vec3 ambient;\n\
@@ -191,13 +196,12 @@ const Shader k3DPipe{
     in vec3 Normal;\n\
     in vec3 FragPos;\n\
     out vec4 FragColor;\n\
-    uniform Light light;\n\
-    uniform vec3 color;\n\
-    uniform vec3 viewPos;\n\
+    uniform Light light;\n"
+    SHADER_ITEM_FRAGMENT
+    "uniform vec3 viewPos;\n\
     uniform vec3 lightPos;\n\
     uniform vec3 lightColor;\n\
     uniform vec3 objectColor;\n\
-    uniform float alfa = 1.0;\n\
     float specularStrength = 0.3;\n\
     float shinines = 128.0;\n\
     void main()\n\
@@ -220,71 +224,65 @@ const Shader k3DPipe{
 };
 
 const Shader k2DPipe{
-    SHADER_VERSION
     "layout (location = 0) in vec3 aPos;\n\
     layout (location = 1) in vec3 aNormal;\n\
     out vec3 Normal;\n\
-    out vec3 FragPos;\n\
-    uniform mat3 normal;\n\
-    uniform mat4 model;\n\
-    uniform mat4 view;\n\
+    out vec3 FragPos;\n"
+    SHADER_ITEM_VERTEX
+    "uniform mat4 view;\n\
     uniform mat4 projection;\n\
     void main()\n\
     {\n\
         gl_Position = projection * view * model * vec4(aPos, 1.0);\n\
         FragPos = vec3(model * vec4(aPos, 1.0));\n\
         Normal = normal * aNormal;\n\
+        ITEM_OUTPUT\n\
     }",
 
-    SHADER_VERSION
     "in vec3 FragPos;\n\
-    out vec4 FragColor;\n\
-    uniform vec3 color;\n\
-    uniform float alfa = 1.0;\n\
-    void main()\n\
+    out vec4 FragColor;\n"
+    SHADER_ITEM_FRAGMENT
+    "void main()\n\
     {\n\
         FragColor = vec4(color, alfa);\n\
     }"
 };
 
 const Shader kSelectionPipe{
-    SHADER_VERSION
-    "layout (location = 0) in vec3 aPos;\n\
+    "#define SCENE_SELECTION\n\
+    layout (location = 0) in vec3 aPos;\n\
     layout (location = 1) in vec3 aNormal;\n\
     out vec3 Normal;\n\
-    out vec3 FragPos;\n\
-    uniform mat3 normal;\n\
-    uniform mat4 model;\n\
-    uniform mat4 view;\n\
+    out vec3 FragPos;\n"
+    SHADER_ITEM_VERTEX
+    "uniform mat4 view;\n\
     uniform mat4 projection;\n\
     void main()\n\
     {\n\
         gl_Position = projection * view * model * vec4(aPos, 1.0);\n\
         FragPos = vec3(model * vec4(aPos, 1.0));\n\
         Normal = normal * aNormal;\n\
+        ITEM_OUTPUT\n\
     }",
 
-    SHADER_VERSION
     "in vec3 FragPos;\n\
-    out vec4 FragColor;\n\
-    uniform vec3 color;\n\
-    void main()\n\
+    out vec4 FragColor;\n"
+    SHADER_ITEM_FRAGMENT
+    "void main()\n\
     {\n\
         FragColor = vec4(color, 1.0);\n\
     }"
 };
 
 const Shader k3DPipeTextured{
-    SHADER_VERSION
     "layout (location = 0) in vec3 aPos;\n\
     layout (location = 1) in vec3 aNormal;\n\
     layout (location = 2) in vec2 aTexCoord;\n\
     out vec3 Normal;\n\
     out vec3 FragPos;\n\
-    out vec2 TexCoord;\n\
-    uniform mat3 normal;\n\
-    uniform mat4 model;\n\
-    uniform mat4 view;\n\
+    out vec2 TexCoord;\n"
+    SHADER_ITEM_VERTEX
+    "uniform mat4 view;\n\
     uniform mat4 projection;\n\
     void main()\n\
     {\n\
@@ -292,9 +290,10 @@ const Shader k3DPipeTextured{
         FragPos = vec3(model * vec4(aPos, 1.0));\n\
         Normal = normal * aNormal;\n\
         TexCoord = aTexCoord;\n\
+        ITEM_OUTPUT\n\
     }",
 
-    SHADER_VERSION
+    SHADER_TEXTURE
     "struct Light {\n\
         vec3 direction;\n\
         vec3 ambient;\n\
@@ -305,14 +304,12 @@ const Shader k3DPipeTextured{
     in vec3 FragPos;\n\
     in vec2 TexCoord;\n\
     out vec4 FragColor;\n\
-    uniform Light light;\n\
-    uniform vec3 color;\n\
-    uniform vec3 viewPos;\n\
+    uniform Light light;\n"
+    SHADER_ITEM_FRAGMENT
+    "uniform vec3 viewPos;\n\
     uniform vec3 lightPos;\n\
     uniform vec3 lightColor;\n\
     uniform vec3 objectColor;\n\
-    uniform float alfa = 1.0;\n\
-    uniform sampler2D textureData;\n\
     float specularStrength = 0.3;\n\
     float shinines = 128.0;\n\
     void main()\n\
@@ -330,21 +327,19 @@ const Shader k3DPipeTextured{
         float spec = pow(max(dot(viewDir, reflectDir), 0.0), shinines);\n\
         vec3 specular = light.specular * spec * specularStrength;\n\
         vec3 result = ambient + diffuse + specular;\n\
-        FragColor = texture(textureData, TexCoord) * vec4(result, alfa);\n\
+        FragColor = textureColor(TexCoord) * vec4(result, alfa);\n\
     }"
 };
 
 const Shader k2DPipeTextured{
-    SHADER_VERSION
     "layout (location = 0) in vec3 aPos;\n\
     layout (location = 1) in vec3 aNormal;\n\
     layout (location = 2) in vec2 aTexCoord;\n\
     out vec3 Normal;\n\
     out vec3 FragPos;\n\
-    out vec2 TexCoord;\n\
-    uniform mat3 normal;\n\
-    uniform mat4 model;\n\
-    uniform mat4 view;\n\
+    out vec2 TexCoord;\n"
+    SHADER_ITEM_VERTEX
+    "uniform mat4 view;\n\
     uniform mat4 projection;\n\
     void main()\n\
     {\n\
@@ -352,46 +347,167 @@ const Shader k2DPipeTextured{
         FragPos = vec3(model * vec4(aPos, 1.0));\n\
         Normal = normal * aNormal;\n\
         TexCoord = aTexCoord;\n\
+        ITEM_OUTPUT\n\
     }",
 
-    SHADER_VERSION
+    SHADER_TEXTURE
     "in vec3 FragPos;\n\
     in vec2 TexCoord;\n\
-    out vec4 FragColor;\n\
-    uniform vec3 color;\n\
-    uniform float alfa = 1.0;\n\
-    uniform sampler2D textureData;\n\
-    void main()\n\
+    out vec4 FragColor;\n"
+    SHADER_ITEM_FRAGMENT
+    "void main()\n\
     {\n\
-        FragColor = texture(textureData, TexCoord) * vec4(color, alfa);\n\
+        FragColor = textureColor(TexCoord) * vec4(color, alfa);\n\
     }"
 };
 
 const Shader kPipeTexturedFlat{
-    SHADER_VERSION
     "layout (location = 0) in vec3 aPos;\n\
     layout (location = 1) in vec3 aNormal;\n\
     layout (location = 2) in vec2 aTexCoord;\n\
-    out vec2 TexCoord;\n\
-    uniform mat3 normal;\n\
-    uniform mat4 model;\n\
-    uniform mat4 view;\n\
+    out vec2 TexCoord;\n"
+    SHADER_ITEM_VERTEX
+    "uniform mat4 view;\n\
     uniform mat4 projection;\n\
     void main()\n\
     {\n\
         gl_Position = vec4(aPos, 1.0);\n\
         TexCoord = aTexCoord;\n\
+        ITEM_OUTPUT\n\
+    }",
+
+    SHADER_TEXTURE
+    "in vec2 TexCoord;\n\
+    out vec4 FragColor;\n"
+    SHADER_ITEM_FRAGMENT
+    "void main()\n\
+    {\n\
+        FragColor = textureColor(TexCoord) * vec4(color, alfa);\n\
+    }"
+};
+
+// the indirect items' visibility by their world bounds (the same test as CameraState::isVisible), the visible items'
+// commands are either compacted to the start of their run (the run's draw count is read from the counts) or are kept
+// in place with the zero instance count for the invisible ones
+const std::string kCulling{
+    "layout (local_size_x = 64) in;\n\
+    struct Item\n\
+    {\n\
+        float model[16];\n\
+        float normal[9];\n\
+        float color[4];\n\
+        float atlasRect[4];\n\
+        float atlasLayer;\n\
+        float idColor[4];\n\
+        float boundsMin[3];\n\
+        float boundsMax[3];\n\
+    };\n\
+    struct Candidate\n\
+    {\n\
+        uint command[5];\n\
+        uint item;\n\
+        uint run;\n\
+        uint runFirst;\n\
+    };\n\
+    layout (std430, binding = 0) readonly buffer Items { Item items[]; };\n\
+    layout (std430, binding = 1) readonly buffer Candidates { Candidate candidates[]; };\n\
+    layout (std430, binding = 2) writeonly buffer Commands { uint commands[]; };\n\
+    layout (std430, binding = 3) buffer Counts { uint counts[]; };\n\
+    uniform vec4 frustum[6];\n\
+    uniform uint candidateCount;\n\
+    uniform bool isCompacting;\n\
+    void main()\n\
+    {\n\
+        uint index = gl_GlobalInvocationID.x;\n\
+        if (index >= candidateCount)\n\
+            return;\n\
+        uint item = candidates[index].item;\n\
+        vec3 boundsMin = vec3(items[item].boundsMin[0], items[item].boundsMin[1], items[item].boundsMin[2]);\n\
+        vec3 boundsMax = vec3(items[item].boundsMax[0], items[item].boundsMax[1], items[item].boundsMax[2]);\n\
+        bool isVisible = true;\n\
+        for (int plane = 0; plane < 6; ++plane)\n\
+        {\n\
+            vec3 corner = mix(boundsMin, boundsMax, step(0.0, frustum[plane].xyz));\n\
+            isVisible = isVisible && dot(frustum[plane].xyz, corner) + frustum[plane].w >= 0.0;\n\
+        }\n\
+        uint slot = index;\n\
+        if (isCompacting)\n\
+        {\n\
+            if (!isVisible)\n\
+                return;\n\
+            slot = candidates[index].runFirst + atomicAdd(counts[candidates[index].run], 1u);\n\
+        }\n\
+        for (uint field = 0u; field < 5u; ++field)\n\
+            commands[slot * 5u + field] = candidates[index].command[field];\n\
+        commands[slot * 5u + 1u] = isVisible ? 1u : 0u;\n\
+    }"
+};
+
+const Shader kText{
+    "layout (location = 0) in vec2 aPos;\n\
+    layout (location = 1) in vec2 aTexCoord;\n\
+    layout (location = 2) in vec4 aColor;\n\
+    out vec2 TexCoord;\n\
+    out vec4 Color;\n\
+    uniform vec2 viewport;\n\
+    void main()\n\
+    {\n\
+        gl_Position = vec4(aPos.x * 2.0 / viewport.x - 1.0, 1.0 - aPos.y * 2.0 / viewport.y, 0.0, 1.0);\n\
+        TexCoord = aTexCoord;\n\
+        Color = aColor;\n\
     }",
 
-    SHADER_VERSION
     "in vec2 TexCoord;\n\
+    in vec4 Color;\n\
     out vec4 FragColor;\n\
-    uniform vec3 color;\n\
-    uniform float alfa = 1.0;\n\
-    uniform sampler2D textureData;\n\
+    uniform sampler2D glyphs;\n\
     void main()\n\
     {\n\
-        FragColor = texture(textureData, TexCoord) * vec4(color, alfa);\n\
+        FragColor = vec4(Color.rgb, Color.a * texture(glyphs, TexCoord).r);\n\
+    }"
+};
+
+const Shader kOverlay{
+    "layout (location = 0) in vec2 aPos;\n\
+    layout (location = 1) in vec4 aColor;\n\
+    out vec4 Color;\n\
+    uniform vec2 viewport;\n\
+    void main()\n\
+    {\n\
+        gl_Position = vec4(aPos.x * 2.0 / viewport.x - 1.0, 1.0 - aPos.y * 2.0 / viewport.y, 0.0, 1.0);\n\
+        Color = aColor;\n\
+    }",
+
+    "in vec4 Color;\n\
+    out vec4 FragColor;\n\
+    void main()\n\
+    {\n\
+        FragColor = Color;\n\
+    }"
+};
+
+// the farthest depth of each tile of the viewport's pixels (see OcclusionCuller), the screen is covered by the single
+// triangle made of the vertex IDs
+const Shader kDepthReduction{
+    "void main()\n\
+    {\n\
+        vec2 position = vec2(float((gl_VertexID & 1) << 2) - 1.0, float((gl_VertexID & 2) << 1) - 1.0);\n\
+        gl_Position = vec4(position, 0.0, 1.0);\n\
+    }",
+
+    "out vec4 FragColor;\n\
+    uniform highp sampler2D depthMap;\n\
+    uniform ivec4 area;\n\
+    uniform int tileSize;\n\
+    void main()\n\
+    {\n\
+        ivec2 origin = area.xy + ivec2(gl_FragCoord.xy) * tileSize;\n\
+        ivec2 last = area.xy + area.zw - 1;\n\
+        float depth = 0.0;\n\
+        for (int y = 0; y < tileSize; ++y)\n\
+            for (int x = 0; x < tileSize; ++x)\n\
+                depth = max(depth, texelFetch(depthMap, min(origin + ivec2(x, y), last), 0).r);\n\
+        FragColor = vec4(depth);\n\
     }"
 };
 // clang-format on
@@ -419,9 +535,33 @@ namespace id
 const TextureID kCommon{0};
 }  // namespace id
 
+const qint64 kUploadBudget{16 << 20};
+const uint kAtlasUnit{1};
+
 const TexturesMap kDefault{};
 }  // namespace textures
 
+namespace quality
+{
+
+// in milliseconds
+const float kTargetFrameTime{1000.0f / 30.0f};
+
+// from the full quality down to the coarsest one
+const QualityLevel::Pack kLevels{{16, 1.0f, true}, {4, 1.0f, true}, {0, 1.0f, false}, {0, 0.75f, false},
+                                 {0, 0.5f, false}};
+}  // namespace quality
+
+namespace batches
+{
+
+// the edge of the cubic chunk the batches are split by, in the world units
+const float kChunkSize{50.0f};
+
+// the batch is compacted once the share of its frozen slots drops below it
+const float kMinFrozenShare{0.5f};
+}  // namespace batches
+
 }  // namespace defaults
 
 }  // namespace gl_scene
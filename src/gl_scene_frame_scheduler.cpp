@@ -0,0 +1,59 @@
+#include "gl_scene_frame_scheduler.h"
+
+using namespace gl_scene;
+
+FrameScheduler::FrameScheduler(const RequestCallback& callback) : mCallback(callback) {}
+
+void FrameScheduler::invalidate(uint reasons)
+{
+    mReasons |= reasons;
+    request();
+}
+
+uint FrameScheduler::beginFrame()
+{
+    const auto reasons = mReasons;
+    mReasons           = 0;
+    mIsRequested       = false;
+    mIsInFlight        = true;
+
+    return reasons;
+}
+
+void FrameScheduler::endFrame()
+{
+    mIsInFlight = false;
+    if (isAnimating())
+    {
+        mReasons |= kAnimation;
+    }
+
+    // the invalidations came while the frame was being rendered are served by the next one
+    if (mReasons != 0)
+    {
+        request();
+    }
+}
+
+void FrameScheduler::startAnimation()
+{
+    mAnimationCount++;
+    invalidate(kAnimation);
+}
+
+void FrameScheduler::stopAnimation()
+{
+    if (mAnimationCount > 0)
+    {
+        mAnimationCount--;
+    }
+}
+
+void FrameScheduler::request()
+{
+    if (!mIsRequested && !mIsInFlight)
+    {
+        mIsRequested = true;
+        mCallback();
+    }
+}
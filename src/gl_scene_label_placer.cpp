@@ -0,0 +1,113 @@
+#include "gl_scene_label_placer.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace gl_scene;
+
+namespace
+{
+
+const int kCellSize{8};
+const float kDepthBias{1e-4f};
+
+}  // namespace
+
+const LabelPlacer::Label::Pack& LabelPlacer::place(const TextItem::Pack& items, const Mat4& transformation,
+                                                    const QSize& size, const BoundsGetter& bounds_getter,
+                                                    const DepthMap* depth_map)
+{
+    mAnchors.clear();
+    mLabels.clear();
+
+    const auto& width  = size.width();
+    const auto& height = size.height();
+    if (width <= 0 || height <= 0)
+    {
+        return mLabels;
+    }
+
+    // the anchors are projected by the matrix rows directly, the matrix is column-major
+    const auto* m = transformation.constData();
+    for (size_t index{0}; index < items.size(); ++index)
+    {
+        const auto& item = items[index];
+        const auto& p    = item.position;
+        const auto& w = m[3] * p.x() + m[7] * p.y() + m[11] * p.z() + m[15];
+        if (item.isEmpty() || w <= 0.0f)
+        {
+            continue;
+        }
+
+        const auto& ndcX = (m[0] * p.x() + m[4] * p.y() + m[8] * p.z() + m[12]) / w;
+        const auto& ndcY = (m[1] * p.x() + m[5] * p.y() + m[9] * p.z() + m[13]) / w;
+
+        if (depth_map != nullptr && std::abs(ndcX) <= 1.0f && std::abs(ndcY) <= 1.0f)
+        {
+            const auto& ndcZ   = (m[2] * p.x() + m[6] * p.y() + m[10] * p.z() + m[14]) / w;
+            const auto& mapW   = depth_map->size.width();
+            const auto& mapH   = depth_map->size.height();
+            const auto& column = std::min(static_cast<int>((ndcX * 0.5f + 0.5f) * mapW), mapW - 1);
+            const auto& row    = std::min(static_cast<int>((ndcY * 0.5f + 0.5f) * mapH), mapH - 1);
+            const auto& index  = static_cast<size_t>(row * mapW + column);
+            if (index < depth_map->depth.size() && ndcZ * 0.5f + 0.5f > depth_map->depth[index] + kDepthBias)
+            {
+                continue;
+            }
+        }
+
+        const auto& x = static_cast<int>(ndcX * width / 2 + width / 2 + item.shiftX);
+        const auto& y = static_cast<int>(height - ndcY * height / 2 - height / 2 + item.shiftY);
+        mAnchors.push_back({&item, index, {x, y}});
+    }
+
+    // the labels with the higher priority take the space first, the equal ones keep the scene's order
+    std::stable_sort(mAnchors.begin(), mAnchors.end(),
+                     [](const Anchor& a, const Anchor& b) { return a.item->priority > b.item->priority; });
+
+    mGridSize = {(width + kCellSize - 1) / kCellSize, (height + kCellSize - 1) / kCellSize};
+    mGrid.assign(static_cast<size_t>(mGridSize.width() * mGridSize.height()), 0);
+
+    const QRect viewport{0, 0, width, height};
+    for (auto& anchor : mAnchors)
+    {
+        const auto& bounds = bounds_getter(anchor.index);
+        if (anchor.item->isHoldInScreen)
+        {
+            anchor.origin.setX(std::min(std::max(anchor.origin.x(), 0), width - bounds.width()));
+            anchor.origin.setY(std::min(std::max(anchor.origin.y(), bounds.height()), height));
+        }
+
+        const auto& rect = bounds.translated(anchor.origin);
+        if (rect.intersects(viewport) && occupy(rect & viewport))
+        {
+            mLabels.push_back({anchor.item, anchor.index, anchor.origin});
+        }
+    }
+
+    return mLabels;
+}
+
+bool LabelPlacer::occupy(const QRect& rect)
+{
+    // the grid is coarse, so the labels closer than the cell size are treated as overlapping
+    const auto& left   = rect.left() / kCellSize;
+    const auto& right  = std::min(rect.right() / kCellSize, mGridSize.width() - 1);
+    const auto& top    = rect.top() / kCellSize;
+    const auto& bottom = std::min(rect.bottom() / kCellSize, mGridSize.height() - 1);
+
+    for (int y{top}; y <= bottom; ++y)
+    {
+        const auto* row = mGrid.data() + y * mGridSize.width();
+        if (std::any_of(row + left, row + right + 1, [](uint8_t cell) { return cell != 0; }))
+        {
+            return false;
+        }
+    }
+
+    for (int y{top}; y <= bottom; ++y)
+    {
+        std::fill_n(mGrid.data() + y * mGridSize.width() + left, right - left + 1, 1);
+    }
+
+    return true;
+}
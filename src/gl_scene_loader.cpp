@@ -1,141 +1,618 @@
 #include "gl_scene_loader.h"
+#include "gl_scene_optimizer.h"
+#include "gl_scene_mesh_cache.h"
 #include <vector>
+#include <thread>
+#include <algorithm>
+#include <climits>
+#include <limits>
+#include <charconv>
 #include <QFileInfo>
+#include <QtConcurrent>
+#include <QDebug>
 
 using namespace gl_scene;
 
-gl_scene::VertexPack gl_scene::ModelLoader::load(const std::string& filename)
+namespace
 {
-    QFileInfo info(QString::fromStdString(filename));
-    if (info.exists())
+
+const qint64 kMinChunkSize{1 << 20};
+const size_t kMinTrianglesPerThread{1 << 16};
+const int kAbsentIndex{INT_MIN};
+const float kLodGridCells[]{64.0f, 32.0f, 16.0f, 8.0f};
+const float kLodMinReduction{0.9f};
+
+enum ObjRelativeFlag : uint8_t
+{
+    kRelativePosition = 1,
+    kRelativeUv       = 2,
+    kRelativeNormal   = 4
+};
+
+struct ObjCorner
+{
+    int position;
+    int uv;
+    int normal;
+    uint8_t relative;
+};
+
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+    std::vector<float> positions;
+    std::vector<float> uvs;
+    std::vector<float> normals;
+    std::vector<ObjCorner> corners;
+    bool isValid{true};
+};
+
+struct ObjData
+{
+    std::vector<float> positions;
+    std::vector<float> uvs;
+    std::vector<float> normals;
+    std::vector<ObjCorner> corners;
+};
+
+template <typename Function>
+void parallelFor(size_t count, Function function)
+{
+    std::vector<std::thread> threads;
+    for (size_t i{1}; i < count; ++i)
     {
-        if (info.completeSuffix() == "obj")
+        threads.emplace_back(function, i);
+    }
+
+    if (count > 0)
+    {
+        function(0);
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+inline bool isLineEnd(char c)
+{
+    return c == '\n' || c == '\r' || c == '#';
+}
+
+inline const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && isSpace(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+inline const char* skipLine(const char* p, const char* end)
+{
+    while (p < end && *p != '\n')
+    {
+        ++p;
+    }
+    return p < end ? p + 1 : end;
+}
+
+inline bool parseFloats(const char*& p, const char* end, std::vector<float>& values, int count)
+{
+    for (int i{0}; i < count; ++i)
+    {
+        p = skipSpaces(p, end);
+        if (p < end && *p == '+')
         {
-            return loadObj(filename);
+            ++p;
+        }
+
+        float value;
+        const auto result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+        {
+            return false;
         }
+
+        values.push_back(value);
+        p = result.ptr;
     }
 
-    return {};
+    return true;
 }
 
-gl_scene::VertexPack gl_scene::ModelLoader::loadObj(const std::string& filename)
+inline bool parseIndex(const char*& p, const char* end, size_t count, int& index, uint8_t& relative, uint8_t flag)
 {
-    std::vector<int> vertexIndices, uvIndices, normalIndices;
-    std::vector<Vec3> temp_vertices;
-    std::vector<Vec2> temp_uvs;
-    std::vector<Vec3> temp_normals;
+    int value{0};
+    const auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc() || value == 0)
+    {
+        return false;
+    }
 
-    QFile file(QString::fromStdString(filename));
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    p = result.ptr;
+    if (value > 0)
     {
-        return {};
+        index = value - 1;
+    }
+    else
+    {
+        // relative index is kept chunk local until the chunks are merged
+        index = static_cast<int>(count) + value;
+        relative |= flag;
     }
 
-    QTextStream in(&file);
-    while (!in.atEnd())
+    return true;
+}
+
+bool parseFace(const char*& p, const char* end, ObjChunk& chunk, std::vector<ObjCorner>& polygon)
+{
+    polygon.clear();
+    while (true)
     {
-        QString line      = in.readLine();
-        auto lineArgs     = line.split(" ");
-        auto lineArgsSize = lineArgs.size();
+        p = skipSpaces(p, end);
+        if (p >= end || isLineEnd(*p))
+        {
+            break;
+        }
 
-        if (lineArgs.empty())
+        ObjCorner corner{kAbsentIndex, kAbsentIndex, kAbsentIndex, 0};
+        if (!parseIndex(p, end, chunk.positions.size() / 3, corner.position, corner.relative, kRelativePosition))
         {
-            file.close();
-            return {};
+            return false;
         }
 
-        QString lineHeader = lineArgs[0];
-        if (lineHeader == "v")
+        if (p < end && *p == '/')
         {
-            Vec3 vertex;
-            if (lineArgsSize >= 4)
+            ++p;
+            if (p < end && *p != '/')
             {
-                vertex[0] = lineArgs[1].toFloat();
-                vertex[1] = lineArgs[2].toFloat();
-                vertex[2] = lineArgs[3].toFloat();
-                temp_vertices.push_back(vertex);
+                if (!parseIndex(p, end, chunk.uvs.size() / 2, corner.uv, corner.relative, kRelativeUv))
+                {
+                    return false;
+                }
             }
+
+            if (p < end && *p == '/')
+            {
+                ++p;
+                if (!parseIndex(p, end, chunk.normals.size() / 3, corner.normal, corner.relative, kRelativeNormal))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (p < end && !isSpace(*p) && !isLineEnd(*p))
+        {
+            return false;
         }
-        else if (lineHeader == "vt")
+
+        polygon.push_back(corner);
+    }
+
+    // polygons are triangulated as a fan around the first corner
+    for (size_t i{2}; i < polygon.size(); ++i)
+    {
+        chunk.corners.push_back(polygon[0]);
+        chunk.corners.push_back(polygon[i - 1]);
+        chunk.corners.push_back(polygon[i]);
+    }
+
+    return true;
+}
+
+void parseChunk(ObjChunk& chunk)
+{
+    // rough estimation for the typical exporters' output, just to avoid most of the reallocations
+    const auto& lines = static_cast<size_t>(chunk.end - chunk.begin) / 32;
+    chunk.positions.reserve(lines * 3 / 2);
+    chunk.normals.reserve(lines * 3 / 2);
+    chunk.uvs.reserve(lines);
+    chunk.corners.reserve(lines * 3 / 2);
+
+    std::vector<ObjCorner> polygon;
+    const char* p   = chunk.begin;
+    const char* end = chunk.end;
+    while (p < end && chunk.isValid)
+    {
+        p = skipSpaces(p, end);
+        if (p + 1 < end && p[0] == 'v')
         {
-            Vec2 uv;
-            if (lineArgsSize >= 3)
+            if (isSpace(p[1]))
+            {
+                p += 1;
+                chunk.isValid = parseFloats(p, end, chunk.positions, 3);
+            }
+            else if (p[1] == 't' && p + 2 < end && isSpace(p[2]))
+            {
+                p += 2;
+                chunk.isValid = parseFloats(p, end, chunk.uvs, 2);
+            }
+            else if (p[1] == 'n' && p + 2 < end && isSpace(p[2]))
             {
-                uv[0] = lineArgs[1].toFloat();
-                uv[1] = -lineArgs[1].toFloat();
-                temp_uvs.push_back(uv);
+                p += 2;
+                chunk.isValid = parseFloats(p, end, chunk.normals, 3);
             }
         }
-        else if (lineHeader == "vn")
+        else if (p + 1 < end && p[0] == 'f' && isSpace(p[1]))
         {
-            Vec3 normal;
-            if (lineArgsSize >= 4)
+            p += 1;
+            chunk.isValid = parseFace(p, end, chunk, polygon);
+        }
+
+        p = skipLine(p, end);
+    }
+}
+
+inline bool resolveIndex(int& index, bool is_relative, int base, int count)
+{
+    if (index == kAbsentIndex)
+    {
+        return true;
+    }
+
+    if (is_relative)
+    {
+        index += base;
+    }
+
+    return index >= 0 && index < count;
+}
+
+bool parseObj(const char* begin, const char* end, ObjData& data)
+{
+    // the file is split into the newline aligned chunks, one chunk per thread
+    const auto& size    = static_cast<qint64>(end - begin);
+    const auto& threads = static_cast<qint64>(std::max(1u, std::thread::hardware_concurrency()));
+    const auto& count   = static_cast<size_t>(std::max<qint64>(1, std::min(threads, size / kMinChunkSize)));
+    std::vector<ObjChunk> chunks(count);
+
+    const char* chunkBegin = begin;
+    for (size_t i{0}; i < count; ++i)
+    {
+        const char* chunkEnd = end;
+        if (i + 1 < count)
+        {
+            chunkEnd = std::max(chunkBegin, begin + size * static_cast<qint64>(i + 1) / static_cast<qint64>(count));
+            chunkEnd = skipLine(chunkEnd, end);
+        }
+
+        chunks[i].begin = chunkBegin;
+        chunks[i].end   = chunkEnd;
+        chunkBegin      = chunkEnd;
+    }
+
+    parallelFor(count, [&](size_t i) { parseChunk(chunks[i]); });
+
+    // the chunks' offsets in the merged streams
+    std::vector<size_t> positionBase(count + 1), uvBase(count + 1), normalBase(count + 1), cornerBase(count + 1);
+    for (size_t i{0}; i < count; ++i)
+    {
+        if (!chunks[i].isValid)
+        {
+            return false;
+        }
+
+        positionBase[i + 1] = positionBase[i] + chunks[i].positions.size();
+        uvBase[i + 1]       = uvBase[i] + chunks[i].uvs.size();
+        normalBase[i + 1]   = normalBase[i] + chunks[i].normals.size();
+        cornerBase[i + 1]   = cornerBase[i] + chunks[i].corners.size();
+    }
+
+    data.positions.resize(positionBase[count]);
+    data.uvs.resize(uvBase[count]);
+    data.normals.resize(normalBase[count]);
+    data.corners.resize(cornerBase[count]);
+
+    const auto& positionCount = static_cast<int>(positionBase[count] / 3);
+    const auto& uvCount       = static_cast<int>(uvBase[count] / 2);
+    const auto& normalCount   = static_cast<int>(normalBase[count] / 3);
+
+    std::vector<char> isResolved(count, 1);
+    parallelFor(count, [&](size_t i) {
+        auto& chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), data.positions.begin() + positionBase[i]);
+        std::copy(chunk.uvs.begin(), chunk.uvs.end(), data.uvs.begin() + uvBase[i]);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), data.normals.begin() + normalBase[i]);
+
+        auto corner = data.corners.begin() + cornerBase[i];
+        for (auto c : chunk.corners)
+        {
+            if (!resolveIndex(c.position, c.relative & kRelativePosition, static_cast<int>(positionBase[i] / 3),
+                              positionCount) ||
+                !resolveIndex(c.uv, c.relative & kRelativeUv, static_cast<int>(uvBase[i] / 2), uvCount) ||
+                !resolveIndex(c.normal, c.relative & kRelativeNormal, static_cast<int>(normalBase[i] / 3), normalCount))
             {
-                normal[0] = lineArgs[1].toFloat();
-                normal[1] = lineArgs[2].toFloat();
-                normal[2] = lineArgs[3].toFloat();
-                temp_normals.push_back(normal);
+                isResolved[i] = 0;
+                return;
             }
+
+            *corner++ = c;
         }
-        else if (lineHeader == "f")
+    });
+
+    return std::all_of(isResolved.begin(), isResolved.end(), [](char is_resolved) { return is_resolved != 0; });
+}
+
+bool readObj(const std::string& filename, ObjData& data)
+{
+    QFile file(QString::fromStdString(filename));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QByteArray buffer;
+    const char* begin = reinterpret_cast<const char*>(file.map(0, file.size()));
+    if (begin == nullptr)
+    {
+        buffer = file.readAll();
+        begin  = buffer.constData();
+    }
+    const char* end = begin + file.size();
+
+    const auto& isParsed = parseObj(begin, end, data);
+    file.close();
+
+    if (!isParsed)
+    {
+        qInfo() << "File can't be read by the OBJ parser:" << QString::fromStdString(filename);
+    }
+
+    return isParsed;
+}
+
+inline Vec3 objPosition(const ObjData& data, const ObjCorner& corner)
+{
+    const auto* p = &data.positions[static_cast<size_t>(corner.position) * 3];
+    return {p[0], p[1], p[2]};
+}
+
+Vertex objVertex(const ObjData& data, const ObjCorner& corner, const Vec3& default_normal)
+{
+    const auto& position = objPosition(data, corner);
+    Vertex vertex{position[0], position[1], position[2], default_normal[0], default_normal[1], default_normal[2]};
+
+    if (corner.normal != kAbsentIndex)
+    {
+        const auto* n = &data.normals[static_cast<size_t>(corner.normal) * 3];
+        vertex[3]     = n[0];
+        vertex[4]     = n[1];
+        vertex[5]     = n[2];
+    }
+
+    if (corner.uv != kAbsentIndex)
+    {
+        const auto* uv = &data.uvs[static_cast<size_t>(corner.uv) * 2];
+        vertex[6]      = uv[0];
+        vertex[7]      = uv[1];
+    }
+
+    return vertex;
+}
+
+bool writeCache(const QString& filename, const Mesh& mesh)
+{
+    if (!mesh.isIndexed())
+    {
+        return MeshCache::write(filename, mesh);
+    }
+
+    const VertexPack vertices(mesh.getVertexData(), mesh.getVertexData() + mesh.getVertexCount());
+    const IndexPack indices(mesh.getIndexData(), mesh.getIndexData() + mesh.getIndexCount());
+
+    std::array<float, 3> min{vertices.front()[0], vertices.front()[1], vertices.front()[2]};
+    std::array<float, 3> max{min};
+    for (const auto& vertex : vertices)
+    {
+        for (size_t c{0}; c < 3; ++c)
+        {
+            min[c] = std::min(min[c], vertex[c]);
+            max[c] = std::max(max[c], vertex[c]);
+        }
+    }
+
+    const auto& extent = std::max({max[0] - min[0], max[1] - min[1], max[2] - min[2]});
+    auto lodIndices    = indices;
+    MeshCache::LodPack lods{{0, static_cast<GLuint>(indices.size()), 0.0f}};
+    for (const auto& cells : kLodGridCells)
+    {
+        if (extent <= 0.0f)
+        {
+            break;
+        }
+
+        const auto& cellSize = extent / cells;
+        auto lod             = MeshOptimizer::simplify(vertices, indices, cellSize);
+        if (lod.empty())
+        {
+            break;
+        }
+
+        if (lod.size() > lods.back().indexCount * kLodMinReduction)
+        {
+            continue;
+        }
+
+        MeshOptimizer::optimizeVertexCache(lod, vertices.size());
+        lods.push_back({static_cast<GLuint>(lodIndices.size()), static_cast<GLuint>(lod.size()), cellSize});
+        lodIndices.insert(lodIndices.end(), lod.begin(), lod.end());
+    }
+
+    return MeshCache::write(filename, Mesh{vertices, lodIndices}, lods);
+}
+
+}  // namespace
+
+gl_scene::VertexPack gl_scene::ModelLoader::load(const std::string& filename)
+{
+    QFileInfo info(QString::fromStdString(filename));
+    if (info.exists())
+    {
+        if (info.completeSuffix() == "obj")
+        {
+            return loadObj(filename);
+        }
+    }
+
+    return {};
+}
+
+gl_scene::Mesh gl_scene::ModelLoader::loadIndexed(const std::string& filename)
+{
+    QFileInfo info(QString::fromStdString(filename));
+    if (info.exists())
+    {
+        if (info.completeSuffix() == "obj")
+        {
+            return loadObjIndexed(filename);
+        }
+    }
+
+    return Mesh{VertexPack{}};
+}
+
+gl_scene::Mesh gl_scene::ModelLoader::loadCached(const std::string& filename, const std::string& cache_dir)
+{
+    const auto& cacheFilename =
+        MeshCache::cacheFilename(QString::fromStdString(filename), QString::fromStdString(cache_dir));
+    if (cacheFilename.isEmpty())
+    {
+        return Mesh{VertexPack{}};
+    }
+
+    if (const auto& cache = MeshCache::open(cacheFilename))
+    {
+        return MeshCache::toMesh(cache);
+    }
+
+    const auto& mesh = loadIndexed(filename);
+    if (mesh.getVertexCount() > 0 && writeCache(cacheFilename, mesh))
+    {
+        if (const auto& cache = MeshCache::open(cacheFilename))
         {
-            int vertexIndex[3]{}, uvIndex[3]{}, normalIndex[3]{};
+            return MeshCache::toMesh(cache);
+        }
+    }
+
+    return mesh;
+}
+
+QFuture<gl_scene::VertexPack> gl_scene::ModelLoader::loadAsync(const std::string& filename)
+{
+    return QtConcurrent::run(&ModelLoader::load, filename);
+}
+
+QFuture<gl_scene::Mesh> gl_scene::ModelLoader::loadCachedAsync(const std::string& filename,
+                                                               const std::string& cache_dir)
+{
+    return QtConcurrent::run(&ModelLoader::loadCached, filename, cache_dir);
+}
 
-            if (lineArgsSize == 4)
+gl_scene::VertexPack gl_scene::ModelLoader::loadObj(const std::string& filename)
+{
+    ObjData data;
+    if (!readObj(filename, data))
+    {
+        return {};
+    }
+
+    // For each vertex of each triangle
+    const auto& triangles = data.corners.size() / 3;
+    const auto& threads   = static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency()));
+    const auto& count     = std::max<size_t>(1, std::min(threads, triangles / kMinTrianglesPerThread));
+    VertexPack vertices(data.corners.size());
+
+    parallelFor(count, [&](size_t i) {
+        const auto& first = triangles * i / count;
+        const auto& last  = triangles * (i + 1) / count;
+        for (size_t t{first}; t < last; ++t)
+        {
+            const auto* corners    = &data.corners[t * 3];
+            const auto& faceNormal = QVector3D::normal(objPosition(data, corners[0]), objPosition(data, corners[1]),
+                                                       objPosition(data, corners[2]));
+            for (size_t c{0}; c < 3; ++c)
             {
-                auto vertexIndexList1 = lineArgs[1].split("/");
-                auto vertexIndexList2 = lineArgs[2].split("/");
-                auto vertexIndexList3 = lineArgs[3].split("/");
-                if ((vertexIndexList1.size() == 3) && (vertexIndexList2.size() == 3) && (vertexIndexList3.size() == 3))
-                {
-                    vertexIndex[0] = vertexIndexList1[0].toInt();
-                    uvIndex[0]     = vertexIndexList1[1].toInt();
-                    normalIndex[0] = vertexIndexList1[2].toInt();
+                vertices[t * 3 + c] = objVertex(data, corners[c], faceNormal);
+            }
+        }
+    });
 
-                    vertexIndex[1] = vertexIndexList2[0].toInt();
-                    uvIndex[1]     = vertexIndexList2[1].toInt();
-                    normalIndex[1] = vertexIndexList2[2].toInt();
+    return vertices;
+}
 
-                    vertexIndex[2] = vertexIndexList3[0].toInt();
-                    uvIndex[2]     = vertexIndexList3[1].toInt();
-                    normalIndex[2] = vertexIndexList3[2].toInt();
-                }
-                else
-                {
-                    qInfo() << "File can't be read by our simple parser :-( Try exporting with other options\n";
-                    file.close();
-                    return {};
-                }
+gl_scene::Mesh gl_scene::ModelLoader::loadObjIndexed(const std::string& filename)
+{
+    ObjData data;
+    if (!readObj(filename, data))
+    {
+        return Mesh{VertexPack{}};
+    }
+
+    // corners without normals get the smooth normal of the position (faces' normals weighted by their area)
+    const auto& positionCount = data.positions.size() / 3;
+    std::vector<Vec3> smoothNormals;
+    for (size_t t{0}; t < data.corners.size() / 3; ++t)
+    {
+        const auto* corners = &data.corners[t * 3];
+        if (corners[0].normal == kAbsentIndex || corners[1].normal == kAbsentIndex ||
+            corners[2].normal == kAbsentIndex)
+        {
+            smoothNormals.resize(positionCount);
+
+            const auto& p1         = objPosition(data, corners[0]);
+            const auto& faceNormal = QVector3D::crossProduct(objPosition(data, corners[1]) - p1,
+                                                             objPosition(data, corners[2]) - p1);
+            for (size_t c{0}; c < 3; ++c)
+            {
+                smoothNormals[static_cast<size_t>(corners[c].position)] += faceNormal;
             }
-            vertexIndices.push_back(vertexIndex[0]);
-            vertexIndices.push_back(vertexIndex[1]);
-            vertexIndices.push_back(vertexIndex[2]);
-            uvIndices.push_back(uvIndex[0]);
-            uvIndices.push_back(uvIndex[1]);
-            uvIndices.push_back(uvIndex[2]);
-            normalIndices.push_back(normalIndex[0]);
-            normalIndices.push_back(normalIndex[1]);
-            normalIndices.push_back(normalIndex[2]);
         }
     }
-    file.close();
 
+    // unique (position, uv, normal) tuples, the variants of each position are chained in the list
+    const GLuint kNoVertex{std::numeric_limits<GLuint>::max()};
+    std::vector<GLuint> heads(positionCount, kNoVertex);
+    std::vector<GLuint> nexts;
+    std::vector<std::pair<int, int>> keys;
     VertexPack vertices;
-    // For each vertex of each triangle
-    for (uint i = 0; i < vertexIndices.size(); i++)
+    IndexPack indices(data.corners.size());
+    vertices.reserve(positionCount);
+
+    for (size_t i{0}; i < data.corners.size(); ++i)
     {
-        // Get the indices of its attributes
-        const auto& vertexIndex = vertexIndices[i];
-        // unsigned int uvIndex = uvIndices[i];
-        const auto& normalIndex = normalIndices[i];
+        const auto& corner   = data.corners[i];
+        const auto& position = static_cast<size_t>(corner.position);
 
-        // Get the attributes thanks to the index
-        Vec3 vertex = temp_vertices[static_cast<uint>(vertexIndex - 1)];
-        // Vec2 uv = temp_uvs[ uvIndex-1 ];
-        Vec3 normal = temp_normals[static_cast<uint>(normalIndex - 1)];
+        auto vertex = heads[position];
+        while (vertex != kNoVertex && (keys[vertex].first != corner.uv || keys[vertex].second != corner.normal))
+        {
+            vertex = nexts[vertex];
+        }
 
-        vertices.push_back({vertex[0], vertex[1], vertex[2], normal[0], normal[1], normal[2]});
+        if (vertex == kNoVertex)
+        {
+            const auto& normal = corner.normal == kAbsentIndex ? smoothNormals[position].normalized() : Vec3{};
+            vertex             = static_cast<GLuint>(vertices.size());
+            vertices.push_back(objVertex(data, corner, normal));
+            keys.push_back({corner.uv, corner.normal});
+            nexts.push_back(heads[position]);
+            heads[position] = vertex;
+        }
+
+        indices[i] = vertex;
     }
 
-    return vertices;
+    MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+    MeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+    return Mesh{vertices, indices};
 }
@@ -8,6 +8,20 @@ using namespace gl_scene;
 Mesh::Mesh(const VertexPack& vertex_pack) : mVertexPack(vertex_pack)
 {}
 
+Mesh::Mesh(const VertexPack& vertex_pack, const IndexPack& index_pack) :
+    mVertexPack(vertex_pack),
+    mIndexPack(index_pack)
+{}
+
+Mesh::Mesh(const std::shared_ptr<const void>& storage, const Vertex* vertex_data, size_t vertex_count,
+           const GLuint* index_data, size_t index_count) :
+    mStorage(storage),
+    mVertexData(vertex_data),
+    mIndexData(index_data),
+    mVertexCount(vertex_count),
+    mIndexCount(index_count)
+{}
+
 Mesh::Mesh(const Point3Pack& point_pack, float z, bool is_generate_normals) : mPointPack(point_pack)
 {
     if (z != 0.0f)
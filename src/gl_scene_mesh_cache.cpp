@@ -0,0 +1,214 @@
+#include "gl_scene_mesh_cache.h"
+#include "gl_scene_defaults.h"
+#include "gl_scene_utility.h"
+#include <QSaveFile>
+#include <cstring>
+
+using namespace gl_scene;
+
+namespace
+{
+
+const char kMagic[4]{'G', 'L', 'S', 'M'};
+const uint32_t kMaxAttributes{8};
+const qint64 kAlignment{64};
+
+struct FileAttribute
+{
+    int32_t size;
+    int32_t stride;
+    int32_t shift;
+};
+
+struct FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexStride;
+    uint32_t attributeCount;
+    FileAttribute attributes[kMaxAttributes];
+    uint64_t vertexCount;
+    uint64_t vertexOffset;
+    uint64_t indexCount;
+    uint64_t indexOffset;
+    uint64_t lodCount;
+    uint64_t lodOffset;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+struct FileLod
+{
+    uint32_t indexFirst;
+    uint32_t indexCount;
+    float error;
+    uint32_t reserved;
+};
+
+inline qint64 aligned(qint64 offset)
+{
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+inline bool isInside(uint64_t offset, uint64_t count, uint64_t element_size, uint64_t file_size)
+{
+    return offset <= file_size && count <= (file_size - offset) / element_size;
+}
+
+bool writeBlob(QSaveFile& file, qint64 offset, const void* data, qint64 size)
+{
+    const QByteArray padding(static_cast<int>(offset - file.pos()), '\0');
+    return file.write(padding) == padding.size() && file.write(reinterpret_cast<const char*>(data), size) == size;
+}
+
+}  // namespace
+
+const uint32_t MeshCache::kVersion{1};
+
+MeshCache::Ptr MeshCache::open(const QString& filename)
+{
+    Ptr cache(new MeshCache);
+    cache->mFile.setFileName(filename);
+    if (!cache->mFile.open(QIODevice::ReadOnly))
+    {
+        return {};
+    }
+
+    const auto& fileSize = static_cast<uint64_t>(cache->mFile.size());
+    if (fileSize < sizeof(FileHeader))
+    {
+        return {};
+    }
+
+    const uchar* data = cache->mFile.map(0, cache->mFile.size());
+    if (data == nullptr)
+    {
+        return {};
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(FileHeader));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.vertexStride != sizeof(Vertex) || header.attributeCount > kMaxAttributes ||
+        !isInside(header.vertexOffset, header.vertexCount, sizeof(Vertex), fileSize) ||
+        !isInside(header.indexOffset, header.indexCount, sizeof(GLuint), fileSize) ||
+        !isInside(header.lodOffset, header.lodCount, sizeof(FileLod), fileSize))
+    {
+        return {};
+    }
+
+    cache->mVertices    = reinterpret_cast<const Vertex*>(data + header.vertexOffset);
+    cache->mIndices     = reinterpret_cast<const GLuint*>(data + header.indexOffset);
+    cache->mVertexCount = header.vertexCount;
+    cache->mIndexCount  = header.indexCount;
+    cache->mBounds.min  = {header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]};
+    cache->mBounds.max  = {header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]};
+
+    for (uint32_t i{0}; i < header.attributeCount; ++i)
+    {
+        const auto& attribute = header.attributes[i];
+        cache->mAttributes.push_back({attribute.size, attribute.stride, attribute.shift});
+    }
+
+    const auto* lods = reinterpret_cast<const FileLod*>(data + header.lodOffset);
+    for (uint64_t i{0}; i < header.lodCount; ++i)
+    {
+        if (header.indexCount > 0 && uint64_t{lods[i].indexFirst} + lods[i].indexCount > header.indexCount)
+        {
+            return {};
+        }
+
+        cache->mLods.push_back({lods[i].indexFirst, lods[i].indexCount, lods[i].error});
+    }
+
+    return cache;
+}
+
+bool MeshCache::write(const QString& filename, const Mesh& mesh, const LodPack& lods)
+{
+    const auto& attributes = defaults::pipes::kAttributes;
+    const auto* vertices   = mesh.getVertexData();
+    const auto& count      = mesh.getVertexCount();
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version        = kVersion;
+    header.vertexStride   = sizeof(Vertex);
+    header.attributeCount = static_cast<uint32_t>(std::min<size_t>(attributes.size(), kMaxAttributes));
+    for (uint32_t i{0}; i < header.attributeCount; ++i)
+    {
+        header.attributes[i] = {attributes[i].size, attributes[i].stride, attributes[i].shift};
+    }
+
+    for (size_t c{0}; c < 3; ++c)
+    {
+        header.boundsMin[c] = count > 0 ? vertices[0][c] : 0.0f;
+        header.boundsMax[c] = header.boundsMin[c];
+    }
+
+    for (size_t i{0}; i < count; ++i)
+    {
+        for (size_t c{0}; c < 3; ++c)
+        {
+            header.boundsMin[c] = std::min(header.boundsMin[c], vertices[i][c]);
+            header.boundsMax[c] = std::max(header.boundsMax[c], vertices[i][c]);
+        }
+    }
+
+    std::vector<FileLod> fileLods;
+    for (const auto& lod : lods)
+    {
+        fileLods.push_back({lod.indexFirst, lod.indexCount, lod.error, 0});
+    }
+
+    if (fileLods.empty())
+    {
+        const auto& indexCount = mesh.isIndexed() ? mesh.getIndexCount() : count;
+        fileLods.push_back({0, static_cast<uint32_t>(indexCount), 0.0f, 0});
+    }
+
+    const auto& lodSize    = static_cast<qint64>(fileLods.size() * sizeof(FileLod));
+    const auto& indexSize  = static_cast<qint64>(mesh.getIndexCount() * sizeof(GLuint));
+    const auto& vertexSize = static_cast<qint64>(count * sizeof(Vertex));
+
+    header.lodCount     = fileLods.size();
+    header.lodOffset    = static_cast<uint64_t>(aligned(sizeof(FileHeader)));
+    header.indexCount   = mesh.getIndexCount();
+    header.indexOffset  = static_cast<uint64_t>(aligned(static_cast<qint64>(header.lodOffset) + lodSize));
+    header.vertexCount  = count;
+    header.vertexOffset = static_cast<uint64_t>(aligned(static_cast<qint64>(header.indexOffset) + indexSize));
+
+    // the container is written into the temporary file and replaces the old one on commit
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    if (!writeBlob(file, 0, &header, sizeof(FileHeader)) ||
+        !writeBlob(file, static_cast<qint64>(header.lodOffset), fileLods.data(), lodSize) ||
+        !writeBlob(file, static_cast<qint64>(header.indexOffset), mesh.getIndexData(), indexSize) ||
+        !writeBlob(file, static_cast<qint64>(header.vertexOffset), vertices, vertexSize))
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+QString MeshCache::cacheFilename(const QString& source_filename, const QString& cache_dir)
+{
+    return gl_scene::cacheFilename(source_filename, cache_dir, "glmesh");
+}
+
+Mesh MeshCache::toMesh(const Ptr& cache)
+{
+    if (cache->mIndexCount == 0 || cache->mLods.empty())
+    {
+        return Mesh{cache, cache->mVertices, cache->mVertexCount, cache->mIndices, cache->mIndexCount};
+    }
+
+    const auto& lod = cache->mLods.front();
+    return Mesh{cache, cache->mVertices, cache->mVertexCount, cache->mIndices + lod.indexFirst, lod.indexCount};
+}
@@ -0,0 +1,333 @@
+#include "gl_scene_occlusion_culler.h"
+#include "gl_scene_defaults.h"
+#include "gl_scene_pipe.h"
+#include <QOpenGLContext>
+#include <algorithm>
+
+using namespace gl_scene;
+
+namespace
+{
+
+// the pixels are reduced by the tiles on the GPU, only the base level is read back
+const int kBaseTexelSize{4};
+const float kDepthBias{1e-5f};
+const float kMinW{1e-5f};
+
+}  // namespace
+
+void OcclusionCuller::capture(GLuint framebuffer, const QSize& buffer_size, const QRect& viewport,
+                               const CameraState& state)
+{
+    const QSize baseSize{(viewport.width() + kBaseTexelSize - 1) / kBaseTexelSize,
+                         (viewport.height() + kBaseTexelSize - 1) / kBaseTexelSize};
+    if (mFence != nullptr || viewport.isEmpty() || !prepare(buffer_size, baseSize))
+    {
+        return;
+    }
+
+    // the multisampled depth is resolved by the same rect only, so the whole buffer is copied
+    auto* functions = QOpenGLContext::currentContext()->extraFunctions();
+    functions->glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    functions->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mDepthFramebuffer);
+    functions->glBlitFramebuffer(0, 0, buffer_size.width(), buffer_size.height(), 0, 0, buffer_size.width(),
+                                 buffer_size.height(), GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    // each fragment of the base level takes the farthest depth of its tile of the viewport's pixels
+    GLint oldViewport[4];
+    functions->glGetIntegerv(GL_VIEWPORT, oldViewport);
+    const auto& isDepthTest = functions->glIsEnabled(GL_DEPTH_TEST);
+    const auto& isBlend     = functions->glIsEnabled(GL_BLEND);
+    functions->glDisable(GL_DEPTH_TEST);
+    functions->glDisable(GL_BLEND);
+    functions->glBindFramebuffer(GL_FRAMEBUFFER, mBaseFramebuffer);
+    functions->glViewport(0, 0, baseSize.width(), baseSize.height());
+    functions->glActiveTexture(GL_TEXTURE0);
+    functions->glBindTexture(GL_TEXTURE_2D, mDepthTexture);
+
+    mProgram->bind();
+    mProgram->setUniformValue("depthMap", 0);
+    mProgram->setUniformValue("tileSize", kBaseTexelSize);
+    functions->glUniform4i(mProgram->uniformLocation("area"), viewport.x(), viewport.y(), viewport.width(),
+                           viewport.height());
+    mVao.bind();
+    functions->glDrawArrays(GL_TRIANGLES, 0, 3);
+    mVao.release();
+    mProgram->release();
+    functions->glBindTexture(GL_TEXTURE_2D, 0);
+
+    functions->glViewport(oldViewport[0], oldViewport[1], oldViewport[2], oldViewport[3]);
+    if (isDepthTest)
+    {
+        functions->glEnable(GL_DEPTH_TEST);
+    }
+
+    if (isBlend)
+    {
+        functions->glEnable(GL_BLEND);
+    }
+
+    // the base level goes into the buffer, so the call returns without waiting for the GPU
+    const auto& size = baseSize.width() * baseSize.height() * static_cast<int>(sizeof(float));
+    mBuffer.bind();
+    if (mBuffer.size() != size)
+    {
+        mBuffer.allocate(size);
+    }
+
+    functions->glReadPixels(0, 0, baseSize.width(), baseSize.height(), GL_RED, GL_FLOAT, nullptr);
+    mBuffer.release();
+
+    mFence        = functions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mIsStale      = false;
+    mCaptureSize  = viewport.size();
+    mCaptureState = state;
+}
+
+void OcclusionCuller::update()
+{
+    if (mFence == nullptr)
+    {
+        return;
+    }
+
+    auto* functions    = QOpenGLContext::currentContext()->extraFunctions();
+    const auto& status = functions->glClientWaitSync(mFence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        return;
+    }
+
+    functions->glDeleteSync(mFence);
+    mFence = nullptr;
+    if (status == GL_WAIT_FAILED || mIsStale)
+    {
+        return;
+    }
+
+    mBuffer.bind();
+    const auto* depth = static_cast<const float*>(mBuffer.mapRange(0, mBuffer.size(), QOpenGLBuffer::RangeRead));
+    if (depth == nullptr)
+    {
+        mBuffer.release();
+        return;
+    }
+
+    // the base level is reduced by the GPU already
+    mLevels.resize(1);
+    auto& base  = mLevels.front();
+    base.width  = (mCaptureSize.width() + kBaseTexelSize - 1) / kBaseTexelSize;
+    base.height = (mCaptureSize.height() + kBaseTexelSize - 1) / kBaseTexelSize;
+    base.depth.assign(depth, depth + base.width * base.height);
+
+    mBuffer.unmap();
+    mBuffer.release();
+
+    // each next level halves the previous one, the odd texels are covered by the clamped pairs
+    while (mLevels.back().width > 1 || mLevels.back().height > 1)
+    {
+        const auto& previous = mLevels.back();
+        Level level{(previous.width + 1) / 2, (previous.height + 1) / 2, {}};
+        level.depth.resize(static_cast<size_t>(level.width * level.height));
+        for (int y{0}; y < level.height; ++y)
+        {
+            const auto& y0 = y * 2;
+            const auto& y1 = std::min(y0 + 1, previous.height - 1);
+            for (int x{0}; x < level.width; ++x)
+            {
+                const auto& x0 = x * 2;
+                const auto& x1 = std::min(x0 + 1, previous.width - 1);
+                const auto& d  = previous.depth;
+                level.depth[static_cast<size_t>(y * level.width + x)] =
+                    std::max(std::max(d[static_cast<size_t>(y0 * previous.width + x0)],
+                                      d[static_cast<size_t>(y0 * previous.width + x1)]),
+                             std::max(d[static_cast<size_t>(y1 * previous.width + x0)],
+                                      d[static_cast<size_t>(y1 * previous.width + x1)]));
+            }
+        }
+
+        mLevels.push_back(std::move(level));
+    }
+
+    mState = mCaptureState;
+}
+
+void OcclusionCuller::reset()
+{
+    mLevels.clear();
+    mIsStale = true;
+}
+
+void OcclusionCuller::destroy()
+{
+    // the view could be destroyed without being shown, then there is neither the context nor the resources
+    auto* context = QOpenGLContext::currentContext();
+    if (context == nullptr || (mDepthFramebuffer == 0 && !mProgram))
+    {
+        mLevels.clear();
+        return;
+    }
+
+    auto* functions = context->extraFunctions();
+    if (mFence != nullptr)
+    {
+        functions->glDeleteSync(mFence);
+        mFence = nullptr;
+    }
+
+    functions->glDeleteFramebuffers(1, &mDepthFramebuffer);
+    functions->glDeleteFramebuffers(1, &mBaseFramebuffer);
+    functions->glDeleteTextures(1, &mDepthTexture);
+    functions->glDeleteTextures(1, &mBaseTexture);
+    mDepthFramebuffer = 0;
+    mBaseFramebuffer  = 0;
+    mDepthTexture     = 0;
+    mBaseTexture      = 0;
+    mDepthSize        = {};
+    mBaseSize         = {};
+    mProgram.reset();
+    mVao.destroy();
+    mBuffer.destroy();
+    mLevels.clear();
+}
+
+bool OcclusionCuller::prepare(const QSize& buffer_size, const QSize& base_size)
+{
+    if (!mIsSupported)
+    {
+        return false;
+    }
+
+    auto* context   = QOpenGLContext::currentContext();
+    auto* functions = context->extraFunctions();
+    if (!mProgram)
+    {
+        mProgram = context->isOpenGLES() ? nullptr : Pipe::makeProgram(defaults::shaders::kDepthReduction);
+        if (!mProgram || !mProgram->isLinked())
+        {
+            mProgram.reset();
+            mIsSupported = false;
+            return false;
+        }
+
+        // the draw goes without the attributes, but the core profile needs the VAO bound
+        mVao.create();
+        mBuffer.setUsagePattern(QOpenGLBuffer::StreamRead);
+        mBuffer.create();
+        functions->glGenTextures(1, &mDepthTexture);
+        functions->glGenTextures(1, &mBaseTexture);
+        functions->glGenFramebuffers(1, &mDepthFramebuffer);
+        functions->glGenFramebuffers(1, &mBaseFramebuffer);
+        for (const auto& texture : {mDepthTexture, mBaseTexture})
+        {
+            functions->glBindTexture(GL_TEXTURE_2D, texture);
+            functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+    }
+
+    // the depth texture takes the scene buffer's packed format, the blit needs the same one
+    if (mDepthSize != buffer_size)
+    {
+        functions->glBindTexture(GL_TEXTURE_2D, mDepthTexture);
+        functions->glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, buffer_size.width(), buffer_size.height(), 0,
+                                GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+        functions->glBindFramebuffer(GL_FRAMEBUFFER, mDepthFramebuffer);
+        functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, mDepthTexture,
+                                          0);
+        mDepthSize = buffer_size;
+    }
+
+    if (mBaseSize != base_size)
+    {
+        functions->glBindTexture(GL_TEXTURE_2D, mBaseTexture);
+        functions->glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, base_size.width(), base_size.height(), 0, GL_RED, GL_FLOAT,
+                                nullptr);
+        functions->glBindFramebuffer(GL_FRAMEBUFFER, mBaseFramebuffer);
+        functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mBaseTexture, 0);
+        mBaseSize = base_size;
+    }
+
+    functions->glBindTexture(GL_TEXTURE_2D, 0);
+
+    return true;
+}
+
+bool OcclusionCuller::isOccluded(const Vec3& min, const Vec3& max) const
+{
+    if (mLevels.empty())
+    {
+        return false;
+    }
+
+    // the corners are projected by the matrix rows directly, the matrix is column-major
+    const auto* m = mState.transformation.constData();
+    float left{1.0f};
+    float right{-1.0f};
+    float bottom{1.0f};
+    float top{-1.0f};
+    float nearest{1.0f};
+    for (int corner{0}; corner < 8; ++corner)
+    {
+        const auto& x = corner & 1 ? max.x() : min.x();
+        const auto& y = corner & 2 ? max.y() : min.y();
+        const auto& z = corner & 4 ? max.z() : min.z();
+        const auto& w = m[3] * x + m[7] * y + m[11] * z + m[15];
+
+        // the box crossing the camera plane could cover anything
+        if (w <= kMinW)
+        {
+            return false;
+        }
+
+        const auto& ndcX = (m[0] * x + m[4] * y + m[8] * z + m[12]) / w;
+        const auto& ndcY = (m[1] * x + m[5] * y + m[9] * z + m[13]) / w;
+        const auto& ndcZ = (m[2] * x + m[6] * y + m[10] * z + m[14]) / w;
+        left             = std::min(left, ndcX);
+        right            = std::max(right, ndcX);
+        bottom           = std::min(bottom, ndcY);
+        top              = std::max(top, ndcY);
+        nearest          = std::min(nearest, ndcZ);
+    }
+
+    // the depth beyond the captured viewport is unknown
+    if (left < -1.0f || right > 1.0f || bottom < -1.0f || top > 1.0f)
+    {
+        return false;
+    }
+
+    const auto& scaleX = static_cast<float>(mCaptureSize.width()) / kBaseTexelSize * 0.5f;
+    const auto& scaleY = static_cast<float>(mCaptureSize.height()) / kBaseTexelSize * 0.5f;
+    auto x0            = (left + 1.0f) * scaleX;
+    auto x1            = (right + 1.0f) * scaleX;
+    auto y0            = (bottom + 1.0f) * scaleY;
+    auto y1            = (top + 1.0f) * scaleY;
+
+    // the level where the box takes at most one texel's size, so it covers at most 2x2 texels
+    size_t levelIndex{0};
+    while (levelIndex + 1 < mLevels.size() && std::max(x1 - x0, y1 - y0) > 1.0f)
+    {
+        x0 *= 0.5f;
+        x1 *= 0.5f;
+        y0 *= 0.5f;
+        y1 *= 0.5f;
+        levelIndex++;
+    }
+
+    const auto& level     = mLevels[levelIndex];
+    const auto& depth     = nearest * 0.5f + 0.5f;
+    const auto& columnEnd = std::min(static_cast<int>(x1), level.width - 1);
+    const auto& rowEnd    = std::min(static_cast<int>(y1), level.height - 1);
+    for (auto row = std::min(static_cast<int>(y0), rowEnd); row <= rowEnd; ++row)
+    {
+        for (auto column = std::min(static_cast<int>(x0), columnEnd); column <= columnEnd; ++column)
+        {
+            if (depth <= level.depth[static_cast<size_t>(row * level.width + column)] + kDepthBias)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,243 @@
+#include "gl_scene_optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+using namespace gl_scene;
+
+namespace
+{
+
+const int kCacheSize{32};
+const float kCacheDecayPower{1.5f};
+const float kLastTriangleScore{0.75f};
+const float kValenceBoostScale{2.0f};
+const float kValenceBoostPower{0.5f};
+const uint32_t kNoTriangle{std::numeric_limits<uint32_t>::max()};
+const GLuint kUnusedVertex{std::numeric_limits<GLuint>::max()};
+const int kCellBits{21};
+
+float vertexScore(int cache_position, uint32_t active_triangles)
+{
+    if (active_triangles == 0)
+    {
+        return -1.0f;
+    }
+
+    float score{0.0f};
+    if (cache_position >= 0)
+    {
+        if (cache_position < 3)
+        {
+            score = kLastTriangleScore;
+        }
+        else
+        {
+            const float scaler = 1.0f / (kCacheSize - 3);
+            score              = std::pow(1.0f - static_cast<float>(cache_position - 3) * scaler, kCacheDecayPower);
+        }
+    }
+
+    return score + kValenceBoostScale * std::pow(static_cast<float>(active_triangles), -kValenceBoostPower);
+}
+
+}  // namespace
+
+void MeshOptimizer::optimizeVertexCache(IndexPack& indices, size_t vertex_count)
+{
+    const auto& triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // triangles adjacent to each vertex
+    std::vector<uint32_t> activeTriangles(vertex_count, 0);
+    for (const auto& index : indices)
+    {
+        activeTriangles[index]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(vertex_count + 1, 0);
+    for (size_t v{0}; v < vertex_count; ++v)
+    {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + activeTriangles[v];
+    }
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t{0}; t < triangleCount; ++t)
+    {
+        for (size_t c{0}; c < 3; ++c)
+        {
+            adjacency[fill[indices[t * 3 + c]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<int> cachePositions(vertex_count, -1);
+    std::vector<float> vertexScores(vertex_count);
+    for (size_t v{0}; v < vertex_count; ++v)
+    {
+        vertexScores[v] = vertexScore(-1, activeTriangles[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> isEmitted(triangleCount, false);
+    for (size_t t{0}; t < triangleCount; ++t)
+    {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+            vertexScores[indices[t * 3 + 2]];
+    }
+
+    IndexPack result;
+    result.reserve(indices.size());
+    std::vector<uint32_t> cache;
+    cache.reserve(kCacheSize + 3);
+    std::vector<uint32_t> newCache;
+    newCache.reserve(kCacheSize + 3);
+
+    uint32_t best{kNoTriangle};
+    size_t cursor{0};
+    for (size_t emitted{0}; emitted < triangleCount; ++emitted)
+    {
+        if (best == kNoTriangle)
+        {
+            // no candidates in the cache, continue with the next not emitted triangle
+            while (isEmitted[cursor])
+            {
+                cursor++;
+            }
+            best = static_cast<uint32_t>(cursor);
+        }
+
+        isEmitted[best] = true;
+        newCache.clear();
+        for (size_t c{0}; c < 3; ++c)
+        {
+            const auto& v = indices[best * 3 + c];
+            result.push_back(v);
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+            {
+                newCache.push_back(v);
+            }
+
+            // remove the triangle from the vertex's adjacency
+            auto* first = &adjacency[adjacencyOffsets[v]];
+            auto* last  = first + activeTriangles[v];
+            auto* it    = std::find(first, last, best);
+            std::swap(*it, *(last - 1));
+            activeTriangles[v]--;
+        }
+
+        for (const auto& v : cache)
+        {
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+            {
+                newCache.push_back(v);
+            }
+        }
+
+        for (size_t i{0}; i < newCache.size(); ++i)
+        {
+            const auto& v     = newCache[i];
+            cachePositions[v] = i < static_cast<size_t>(kCacheSize) ? static_cast<int>(i) : -1;
+            vertexScores[v]   = vertexScore(cachePositions[v], activeTriangles[v]);
+        }
+
+        // the best candidate is chosen among triangles touched by the cached vertices
+        best = kNoTriangle;
+        float bestScore{-1.0f};
+        for (const auto& v : newCache)
+        {
+            for (uint32_t i{0}; i < activeTriangles[v]; ++i)
+            {
+                const auto& t     = adjacency[adjacencyOffsets[v] + i];
+                triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+                    vertexScores[indices[t * 3 + 2]];
+
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    best      = t;
+                }
+            }
+        }
+
+        if (newCache.size() > static_cast<size_t>(kCacheSize))
+        {
+            newCache.resize(kCacheSize);
+        }
+        std::swap(cache, newCache);
+    }
+
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(VertexPack& vertices, IndexPack& indices)
+{
+    std::vector<GLuint> remap(vertices.size(), kUnusedVertex);
+    VertexPack result;
+    result.reserve(vertices.size());
+
+    for (auto& index : indices)
+    {
+        auto& newIndex = remap[index];
+        if (newIndex == kUnusedVertex)
+        {
+            newIndex = static_cast<GLuint>(result.size());
+            result.push_back(vertices[index]);
+        }
+
+        index = newIndex;
+    }
+
+    vertices.swap(result);
+}
+
+IndexPack MeshOptimizer::simplify(const VertexPack& vertices, const IndexPack& indices, float cell_size)
+{
+    if (vertices.empty() || cell_size <= 0.0f)
+    {
+        return indices;
+    }
+
+    std::array<float, 3> min{vertices.front()[0], vertices.front()[1], vertices.front()[2]};
+    for (const auto& vertex : vertices)
+    {
+        for (size_t c{0}; c < 3; ++c)
+        {
+            min[c] = std::min(min[c], vertex[c]);
+        }
+    }
+
+    const uint64_t cellMask{(uint64_t{1} << kCellBits) - 1};
+    std::unordered_map<uint64_t, GLuint> cells;
+    std::vector<GLuint> remap(vertices.size(), kUnusedVertex);
+    for (size_t i{0}; i < vertices.size(); ++i)
+    {
+        uint64_t key{0};
+        for (size_t c{0}; c < 3; ++c)
+        {
+            const auto& cell = static_cast<uint64_t>((vertices[i][c] - min[c]) / cell_size);
+            key              = (key << kCellBits) | (cell & cellMask);
+        }
+
+        remap[i] = cells.emplace(key, static_cast<GLuint>(i)).first->second;
+    }
+
+    IndexPack result;
+    result.reserve(indices.size());
+    for (size_t i{0}; i + 2 < indices.size(); i += 3)
+    {
+        const auto& a = remap[indices[i]];
+        const auto& b = remap[indices[i + 1]];
+        const auto& c = remap[indices[i + 2]];
+        if (a != b && b != c && a != c)
+        {
+            result.insert(result.end(), {a, b, c});
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,64 @@
+#include "gl_scene_overlay_renderer.h"
+#include "gl_scene_defaults.h"
+#include <QLineF>
+
+using namespace gl_scene;
+
+OverlayRenderer::OverlayRenderer() :
+    mPipe(std::make_shared<ScreenPipe>(defaults::shaders::kOverlay, defaults::pipes::kOverlayAttributes))
+{}
+
+void OverlayRenderer::addLine(const QPointF& p1, const QPointF& p2, const Color& color, float width)
+{
+    const auto& normal = QLineF(p1, p2).normalVector().unitVector();
+    const auto& shift  = QPointF(normal.dx(), normal.dy()) * (width / 2);
+    addQuad(p1 - shift, p1 + shift, p2 - shift, p2 + shift, color);
+}
+
+void OverlayRenderer::addFrame(const QRectF& rect, const Color& color, float width)
+{
+    // the frame is built by the four filled strips, so the corners are covered once
+    const auto& r = rect.normalized();
+    addRect({r.left(), r.top(), r.width(), width}, color);
+    addRect({r.left(), r.bottom() - width, r.width(), width}, color);
+    addRect({r.left(), r.top() + width, width, r.height() - width * 2}, color);
+    addRect({r.right() - width, r.top() + width, width, r.height() - width * 2}, color);
+}
+
+void OverlayRenderer::addRect(const QRectF& rect, const Color& color)
+{
+    if (rect.width() > 0 && rect.height() > 0)
+    {
+        addQuad(rect.topLeft(), rect.bottomLeft(), rect.topRight(), rect.bottomRight(), color);
+    }
+}
+
+void OverlayRenderer::render(const QSize& size)
+{
+    if (mVertices.empty())
+    {
+        return;
+    }
+
+    mPipe->bind();
+    mPipe->allocate(mVertices.data(), static_cast<int>(mVertices.size() * sizeof(OverlayVertex)));
+    mPipe->setViewport(size);
+    mPipe->glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(mVertices.size()));
+    mPipe->release();
+
+    mVertices.clear();
+}
+
+void OverlayRenderer::addQuad(const QPointF& p1, const QPointF& p2, const QPointF& p3, const QPointF& p4,
+                              const Color& color)
+{
+    const auto& r = static_cast<float>(color.redF());
+    const auto& g = static_cast<float>(color.greenF());
+    const auto& b = static_cast<float>(color.blueF());
+    const auto& a = static_cast<float>(color.alphaF());
+
+    for (const auto* point : {&p1, &p2, &p3, &p3, &p2, &p4})
+    {
+        mVertices.push_back({static_cast<float>(point->x()), static_cast<float>(point->y()), r, g, b, a});
+    }
+}
@@ -1,99 +1,610 @@
 #include "gl_scene_pipe.h"
 #include "gl_scene_utility.h"
+#include "gl_scene_capabilities.h"
+#include "gl_scene_batch.h"
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLContext>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 
 using namespace gl_scene;
 
-Pipe::Pipe(const Shader& shader, const void* data, int count, const Attributes& attributes)
+namespace
 {
-    initializeOpenGLFunctions();
-    create();
-    addShaderFromSourceCode(shader);
-    bind();
-    allocate(data, count);
-    addAttributes(attributes);
-    release();
+
+const GLenum kDrawIndirectBuffer{0x8F3F};
+const GLenum kShaderStorageBuffer{0x90D2};
+const GLenum kParameterBuffer{0x80EE};
+const GLbitfield kCommandBarrierBit{0x00000040};
+
+// the local size of the culling shader
+const GLuint kCullingGroupSize{64};
+
+// the batch's vertex attributes (see Batch::Vertex) and the locations of the per draw attributes (SCENE_INDIRECT)
+const Pipe::Attributes kBatchAttributes{{3, 16, 0}, {3, 16, 3}, {2, 16, 6}};
+const GLuint kModelLocation{3};
+const GLuint kNormalLocation{7};
+const GLuint kColorLocation{10};
+const GLuint kAtlasRectLocation{11};
+const GLuint kAtlasLayerLocation{12};
+const GLuint kIdColorLocation{13};
+
+// the dirty ranges closer than that are merged, a few unchanged records are uploaded instead of the separate call
+const GLuint kDirtyRangeGap{8};
+
+void allocateSegments(QOpenGLBuffer& buffer, const BufferSegments& segments)
+{
+    int size{0};
+    for (const auto& segment : segments)
+    {
+        size += segment.size;
+    }
+
+    if (size > 0)
+    {
+        buffer.allocate(size);
+
+        int offset{0};
+        for (const auto& segment : segments)
+        {
+            buffer.write(offset, segment.data, segment.size);
+            offset += segment.size;
+        }
+    }
+}
+
+Pipe::Resources makeResources(const Shader& shader, const BufferSegments& vertex_segments,
+                              const BufferSegments& index_segments)
+{
+    auto resources    = Pipe::makeBuffers(vertex_segments, index_segments);
+    resources.program = Pipe::makeProgram(shader);
+
+    return resources;
+}
+
+}  // namespace
+
+std::shared_ptr<QOpenGLShaderProgram> Pipe::makeProgram(const Shader& shader)
+{
+    const auto& capabilities = Capabilities::detect();
+    auto program             = std::make_shared<QOpenGLShaderProgram>();
+    program->addShaderFromSourceCode(QOpenGLShader::Vertex, capabilities.toShaderSource(shader.mVertex).c_str());
+    program->addShaderFromSourceCode(QOpenGLShader::Fragment, capabilities.toShaderSource(shader.mFragment).c_str());
+    program->link();
+
+    return program;
 }
 
-void Pipe::create()
+Pipe::Resources Pipe::makeBuffers(const BufferSegments& vertex_segments, const BufferSegments& index_segments)
 {
+    Resources resources;
+    resources.vbo = std::make_shared<QOpenGLBuffer>();
+    resources.vbo->create();
+    resources.vbo->bind();
+    allocateSegments(*resources.vbo, vertex_segments);
+    resources.vbo->release();
+
+    if (!index_segments.empty())
+    {
+        // the index buffer is bound to the pipe's VAO later, the temporary one keeps the current VAO unchanged
+        QOpenGLVertexArrayObject vao;
+        vao.create();
+        QOpenGLVertexArrayObject::Binder binder(&vao);
+
+        resources.ibo = std::make_shared<QOpenGLBuffer>(QOpenGLBuffer::IndexBuffer);
+        resources.ibo->create();
+        resources.ibo->bind();
+        allocateSegments(*resources.ibo, index_segments);
+        resources.ibo->release();
+    }
+
+    return resources;
+}
+
+Pipe::Pipe(const Shader& shader, const void* data, int count, const Attributes& attributes, const void* index_data,
+           int index_count) :
+    Pipe(shader, BufferSegments{{data, data != nullptr ? count : 0}}, attributes,
+         index_data != nullptr && index_count > 0 ? BufferSegments{{index_data, index_count}} : BufferSegments{})
+{}
+
+Pipe::Pipe(const Shader& shader, const BufferSegments& vertex_segments, const Attributes& attributes,
+           const BufferSegments& index_segments) :
+    Pipe(makeResources(shader, vertex_segments, index_segments), attributes)
+{}
+
+Pipe::Pipe(const Resources& resources, const Attributes& attributes) :
+    program(resources.program),
+    vbo(resources.vbo),
+    ibo(resources.ibo)
+{
+    initializeOpenGLFunctions();
     vao.create();
-    vbo.create();
-    program.create();
+    if (!vbo)
+    {
+        vbo = std::make_shared<QOpenGLBuffer>();
+        vbo->create();
+    }
+
+    bind();
+    if (ibo)
+    {
+        ibo->bind();
+    }
+    addAttributes(attributes);
+    release();
 }
 
 void Pipe::bind()
 {
-    program.bind();
+    program->bind();
     vao.bind();
-    vbo.bind();
+    vbo->bind();
 }
 
 void Pipe::release()
 {
-    program.release();
+    program->release();
     vao.release();
-    vbo.release();
+    vbo->release();
 }
 
 void Pipe::allocate(const void* data, int count)
 {
     if (data != nullptr && count > 0)
     {
-        vbo.allocate(data, count);
+        vbo->allocate(data, count);
     }
 }
 
-void Pipe::setView(const Vec3& position, const Mat4& projection, const Mat4& view)
+void Pipe::allocateIndices(const void* data, int count)
 {
-    program.setUniformValue("viewPos", position);
-    program.setUniformValue("projection", projection);
-    program.setUniformValue("view", view);
+    if (data != nullptr && count > 0)
+    {
+        if (!ibo)
+        {
+            ibo = std::make_shared<QOpenGLBuffer>(QOpenGLBuffer::IndexBuffer);
+            ibo->create();
+        }
+        ibo->bind();
+        ibo->allocate(data, count);
+    }
+}
+
+void Pipe::allocate(const BufferSegments& segments)
+{
+    allocateSegments(*vbo, segments);
+}
+
+void Pipe::allocateIndices(const BufferSegments& segments)
+{
+    if (!segments.empty())
+    {
+        if (!ibo)
+        {
+            ibo = std::make_shared<QOpenGLBuffer>(QOpenGLBuffer::IndexBuffer);
+            ibo->create();
+        }
+        ibo->bind();
+        allocateSegments(*ibo, segments);
+    }
 }
 
-void Pipe::addShaderFromSourceCode(const Shader& shader)
+void Pipe::setView(const Vec3& position, const Mat4& projection, const Mat4& view)
 {
-    program.addShaderFromSourceCode(QOpenGLShader::Vertex, shader.mVertex.c_str());
-    program.addShaderFromSourceCode(QOpenGLShader::Fragment, shader.mFragment.c_str());
-    program.link();
+    program->setUniformValue("viewPos", position);
+    program->setUniformValue("projection", projection);
+    program->setUniformValue("view", view);
 }
 
 void Pipe::addAttributes(const Attributes& attributes)
+{
+    vertexAttributes = attributes;
+    setBaseVertex(0);
+}
+
+void Pipe::setBaseVertex(GLint base_vertex)
 {
     GLuint index{0};
-    for (const auto& attribute : attributes)
+    for (const auto& attribute : vertexAttributes)
     {
+        const auto& shift = static_cast<uint>(attribute.shift + attribute.stride * base_vertex);
         glEnableVertexAttribArray(index);
         glVertexAttribPointer(index, attribute.size, GL_FLOAT, GL_FALSE,
                               attribute.stride * static_cast<GLsizei>(sizeof(GLfloat)),
-                              reinterpret_cast<void*>(sizeof(GLfloat) * static_cast<uint>(attribute.shift)));
+                              reinterpret_cast<void*>(sizeof(GLfloat) * shift));
         index++;
     }
+
+    baseVertex = base_vertex;
 }
 
 void Pipe::setTransform(const Mat4& model)
 {
-    program.setUniformValue("normal", model.normalMatrix());
-    program.setUniformValue("model", model);
+    program->setUniformValue("normal", model.normalMatrix());
+    program->setUniformValue("model", model);
 }
 
-PipeExt::PipeExt(const Shader& shader, const void* pipe_data, int count, const Attributes& attributes) :
-    Pipe(shader, pipe_data, count, attributes)
+PipeExt::PipeExt(const Shader& shader, const void* pipe_data, int count, const Attributes& attributes,
+                 const void* index_data, int index_count) :
+    Pipe(shader, pipe_data, count, attributes, index_data, index_count)
+{}
+
+PipeExt::PipeExt(const Shader& shader, const BufferSegments& vertex_segments, const Attributes& attributes,
+                 const BufferSegments& index_segments) :
+    Pipe(shader, vertex_segments, attributes, index_segments)
 {}
 
+PipeExt::PipeExt(const Resources& resources, const Attributes& attributes) : Pipe(resources, attributes) {}
+
 void PipeExt::setLight(const Light& light)
 {
-    program.setUniformValue("light.direction", light.direction);
-    program.setUniformValue("light.ambient", toVec3(light.ambient));
-    program.setUniformValue("light.diffuse", toVec3(light.diffuse));
-    program.setUniformValue("light.specular", toVec3(light.specular));
+    program->setUniformValue("light.direction", light.direction);
+    program->setUniformValue("light.ambient", toVec3(light.ambient));
+    program->setUniformValue("light.diffuse", toVec3(light.diffuse));
+    program->setUniformValue("light.specular", toVec3(light.specular));
 }
 
 void PipeExt::setColor(const Color& color)
 {
-    program.setUniformValue("color", toVec3(color));
+    program->setUniformValue("color", toVec3(color));
 }
 
 void PipeExt::setAlfa(float alfa)
 {
-    program.setUniformValue("alfa", alfa);
+    program->setUniformValue("alfa", alfa);
+}
+
+void PipeExt::setTextureUnits(uint texture_unit, uint atlas_unit)
+{
+    program->setUniformValue("textureData", texture_unit);
+    program->setUniformValue("textureAtlas", atlas_unit);
+}
+
+void PipeExt::setAtlasRegion(int layer, const QVector4D& rect)
+{
+    program->setUniformValue("atlasLayer", layer);
+    program->setUniformValue("atlasRect", rect);
+}
+
+IndirectPipe::IndirectPipe(const Resources& resources, const Attributes& attributes,
+                           const std::shared_ptr<QOpenGLShaderProgram>& selection_program) :
+    PipeExt(resources, attributes),
+    drawProgram(program),
+    selectionProgram(selection_program)
+{
+    auto* context   = QOpenGLContext::currentContext();
+    auto* functions = context->extraFunctions();
+    multiDrawArraysIndirect =
+        reinterpret_cast<MultiDrawArraysIndirect>(context->getProcAddress("glMultiDrawArraysIndirect"));
+    multiDrawElementsIndirect =
+        reinterpret_cast<MultiDrawElementsIndirect>(context->getProcAddress("glMultiDrawElementsIndirect"));
+
+    // the draw count is read from the buffer by the core OpenGL 4.6 or by the extension, the drivers could return
+    // the pointers of the functions they don't support, so they're taken only if the context reports the feature
+    const auto& isIndirectCount = Capabilities::detect().isIndirectCount;
+    for (const auto& suffix : {"", "ARB"})
+    {
+        if (isIndirectCount && (multiDrawElementsIndirectCount == nullptr || multiDrawArraysIndirectCount == nullptr))
+        {
+            multiDrawArraysIndirectCount = reinterpret_cast<MultiDrawArraysIndirectCount>(
+                context->getProcAddress(QByteArray("glMultiDrawArraysIndirectCount") + suffix));
+            multiDrawElementsIndirectCount = reinterpret_cast<MultiDrawElementsIndirectCount>(
+                context->getProcAddress(QByteArray("glMultiDrawElementsIndirectCount") + suffix));
+        }
+    }
+
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &candidateBuffer);
+    glGenBuffers(1, &countBuffer);
+    itemBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    itemBuffer.create();
+
+    // the matrices take the location per column
+    const std::vector<std::pair<GLint, size_t>> itemAttributes{
+        {4, offsetof(ItemData, model)},
+        {4, offsetof(ItemData, model) + 4 * sizeof(GLfloat)},
+        {4, offsetof(ItemData, model) + 8 * sizeof(GLfloat)},
+        {4, offsetof(ItemData, model) + 12 * sizeof(GLfloat)},
+        {3, offsetof(ItemData, normal)},
+        {3, offsetof(ItemData, normal) + 3 * sizeof(GLfloat)},
+        {3, offsetof(ItemData, normal) + 6 * sizeof(GLfloat)},
+        {4, offsetof(ItemData, color)},
+        {4, offsetof(ItemData, atlasRect)},
+        {1, offsetof(ItemData, atlasLayer)},
+        {4, offsetof(ItemData, idColor)}};
+
+    vao.bind();
+    itemBuffer.bind();
+    auto index = static_cast<GLuint>(vertexAttributes.size());
+    for (const auto& attribute : itemAttributes)
+    {
+        glEnableVertexAttribArray(index);
+        glVertexAttribPointer(index, attribute.first, GL_FLOAT, GL_FALSE, sizeof(ItemData),
+                              reinterpret_cast<void*>(attribute.second));
+        functions->glVertexAttribDivisor(index, 1);
+        index++;
+    }
+    vao.release();
+    itemBuffer.release();
+}
+
+IndirectPipe::~IndirectPipe()
+{
+    glDeleteBuffers(1, &commandBuffer);
+    glDeleteBuffers(1, &candidateBuffer);
+    glDeleteBuffers(1, &countBuffer);
+}
+
+void IndirectPipe::setItem(GLuint index, const ItemData& item)
+{
+    if (index >= items.size())
+    {
+        items.resize(index + 1);
+    }
+    else if (std::memcmp(&items[index], &item, sizeof(ItemData)) == 0)
+    {
+        return;
+    }
+
+    items[index] = item;
+    auto* range  = dirtyRanges.empty() ? nullptr : &dirtyRanges.back();
+    if (range && index >= range->first && index <= range->second + kDirtyRangeGap)
+    {
+        range->second = std::max(range->second, index + 1);
+    }
+    else
+    {
+        dirtyRanges.push_back({index, index + 1});
+    }
+}
+
+void IndirectPipe::uploadItems()
+{
+    if (dirtyRanges.empty())
+    {
+        return;
+    }
+
+    itemBuffer.bind();
+    if (items.size() > allocatedItemsCount)
+    {
+        // the table grows by doubling, so it's reallocated rarely
+        allocatedItemsCount = std::max(items.size(), allocatedItemsCount * 2);
+        itemBuffer.allocate(static_cast<int>(allocatedItemsCount * sizeof(ItemData)));
+        itemBuffer.write(0, items.data(), static_cast<int>(items.size() * sizeof(ItemData)));
+    }
+    else
+    {
+        for (const auto& range : dirtyRanges)
+        {
+            itemBuffer.write(static_cast<int>(range.first * sizeof(ItemData)), &items[range.first],
+                             static_cast<int>((range.second - range.first) * sizeof(ItemData)));
+        }
+    }
+
+    dirtyRanges.clear();
+    vbo->bind();
+}
+
+GLsizei IndirectPipe::addCommand(const GeometryData& geometry, GLuint item_index, bool is_new_run)
+{
+    const auto& index = static_cast<GLuint>(candidates.size());
+    const auto& count = static_cast<GLuint>(geometry.count);
+    const auto& first = static_cast<GLuint>(geometry.first);
+    const auto& isRun = !candidates.empty() && !is_new_run;
+
+    Candidate candidate{};
+    candidate.command  = geometry.isIndexed ? Command{count, 1, first, geometry.baseVertex, item_index}
+                                            : Command{count, 1, first, static_cast<GLint>(item_index), 0};
+    candidate.item     = item_index;
+    candidate.run      = candidates.empty() ? 0 : candidates.back().run + (isRun ? 0 : 1);
+    candidate.runFirst = isRun ? candidates.back().runFirst : index;
+    candidates.push_back(candidate);
+
+    return static_cast<GLsizei>(index);
+}
+
+void IndirectPipe::uploadCommands()
+{
+    // the commands are mostly the same for the next frame and for the next viewport
+    const auto& buffer = isGpuCulling ? candidateBuffer : commandBuffer;
+    const auto& size   = static_cast<GLsizeiptr>(candidates.size() * sizeof(Candidate));
+    if (buffer != uploadedBuffer || candidates.size() != uploadedCandidates.size() ||
+        std::memcmp(candidates.data(), uploadedCandidates.data(), static_cast<size_t>(size)) != 0)
+    {
+        glBindBuffer(kDrawIndirectBuffer, buffer);
+        glBufferData(kDrawIndirectBuffer, size, candidates.data(), GL_DYNAMIC_DRAW);
+        if (isGpuCulling)
+        {
+            const auto& runCount = candidates.empty() ? 0 : candidates.back().run + 1;
+            glBindBuffer(kDrawIndirectBuffer, commandBuffer);
+            glBufferData(kDrawIndirectBuffer, static_cast<GLsizeiptr>(candidates.size() * sizeof(Command)), nullptr,
+                         GL_DYNAMIC_DRAW);
+            glBindBuffer(kDrawIndirectBuffer, countBuffer);
+            glBufferData(kDrawIndirectBuffer, static_cast<GLsizeiptr>(runCount * sizeof(GLuint)), nullptr,
+                         GL_DYNAMIC_DRAW);
+        }
+        glBindBuffer(kDrawIndirectBuffer, 0);
+
+        std::swap(candidates, uploadedCandidates);
+        uploadedBuffer = buffer;
+    }
+
+    candidates.clear();
+}
+
+void IndirectPipe::cull(QOpenGLShaderProgram& culling_program, const CameraState::Planes& frustum)
+{
+    const auto& count = static_cast<GLuint>(uploadedCandidates.size());
+    if (!isGpuCulling || count == 0)
+    {
+        return;
+    }
+
+    // the runs' counters start from zero
+    if (isCompacting())
+    {
+        const std::vector<GLuint> counts(uploadedCandidates.back().run + 1, 0);
+        glBindBuffer(kShaderStorageBuffer, countBuffer);
+        glBufferSubData(kShaderStorageBuffer, 0, static_cast<GLsizeiptr>(counts.size() * sizeof(GLuint)),
+                        counts.data());
+        glBindBuffer(kShaderStorageBuffer, 0);
+    }
+
+    auto* functions = QOpenGLContext::currentContext()->extraFunctions();
+    culling_program.bind();
+    culling_program.setUniformValueArray("frustum", frustum.data(), static_cast<int>(frustum.size()));
+    culling_program.setUniformValue("candidateCount", count);
+    culling_program.setUniformValue("isCompacting", static_cast<GLint>(isCompacting()));
+    functions->glBindBufferBase(kShaderStorageBuffer, 0, itemBuffer.bufferId());
+    functions->glBindBufferBase(kShaderStorageBuffer, 1, candidateBuffer);
+    functions->glBindBufferBase(kShaderStorageBuffer, 2, commandBuffer);
+    functions->glBindBufferBase(kShaderStorageBuffer, 3, countBuffer);
+    functions->glDispatchCompute((count + kCullingGroupSize - 1) / kCullingGroupSize, 1, 1);
+
+    // the commands and the counts are read by the draws
+    functions->glMemoryBarrier(kCommandBarrierBit);
+    culling_program.release();
+}
+
+void IndirectPipe::draw(GLenum mode, bool is_indexed, GLsizei first, GLsizei count)
+{
+    // the culled commands are packed, the others are read from the candidates
+    const auto& stride = static_cast<GLsizei>(isGpuCulling ? sizeof(Command) : sizeof(Candidate));
+    const auto* offset = reinterpret_cast<void*>(static_cast<size_t>(first) * static_cast<size_t>(stride));
+    glBindBuffer(kDrawIndirectBuffer, commandBuffer);
+    if (isGpuCulling && isCompacting())
+    {
+        // the run's draw count is written by the culling
+        const auto& run         = uploadedCandidates[static_cast<size_t>(first)].run;
+        const auto& countOffset = static_cast<GLintptr>(run * sizeof(GLuint));
+        glBindBuffer(kParameterBuffer, countBuffer);
+        if (is_indexed)
+        {
+            multiDrawElementsIndirectCount(mode, GL_UNSIGNED_INT, offset, countOffset, count, stride);
+        }
+        else
+        {
+            multiDrawArraysIndirectCount(mode, offset, countOffset, count, stride);
+        }
+        glBindBuffer(kParameterBuffer, 0);
+    }
+    else if (is_indexed)
+    {
+        multiDrawElementsIndirect(mode, GL_UNSIGNED_INT, offset, count, stride);
+    }
+    else
+    {
+        multiDrawArraysIndirect(mode, offset, count, stride);
+    }
+    glBindBuffer(kDrawIndirectBuffer, 0);
+}
+
+void IndirectPipe::setSelection(bool is_selection)
+{
+    program = is_selection && selectionProgram ? selectionProgram : drawProgram;
+}
+
+bool IndirectPipe::isCompacting() const
+{
+    return multiDrawArraysIndirectCount && multiDrawElementsIndirectCount;
+}
+
+BatchPipe::BatchPipe(const std::shared_ptr<QOpenGLShaderProgram>& program,
+                     const std::shared_ptr<QOpenGLShaderProgram>& selection_program) :
+    PipeExt(Resources{program}, kBatchAttributes),
+    drawProgram(program),
+    selectionProgram(selection_program)
+{
+    // the colors are taken per vertex, the other per draw attributes' arrays stay disabled
+    const auto& stride = static_cast<GLsizei>(sizeof(Batch::Vertex));
+    vao.bind();
+    vbo->bind();
+    const std::vector<std::pair<GLuint, size_t>> colorAttributes{{kColorLocation, 8 * sizeof(GLfloat)},
+                                                                 {kIdColorLocation, 12 * sizeof(GLfloat)}};
+    for (const auto& attribute : colorAttributes)
+    {
+        glEnableVertexAttribArray(attribute.first);
+        glVertexAttribPointer(attribute.first, 4, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<void*>(attribute.second));
+    }
+    vao.release();
+    vbo->release();
+}
+
+void BatchPipe::upload(const Batch& batch)
+{
+    // the thaws collapse the vertices of their slots, the appends and the compactions change the whole layout
+    if (isUploaded && uploadedRevision == batch.revision)
+    {
+        return;
+    }
+
+    const auto& vertexSize = static_cast<int>(sizeof(Batch::Vertex));
+    vbo->bind();
+    if (!isUploaded || batch.layoutRevision > uploadedRevision)
+    {
+        vbo->allocate(batch.vertices.data(), static_cast<int>(batch.vertices.size()) * vertexSize);
+    }
+    else
+    {
+        for (const auto& slot : batch.slots)
+        {
+            if (slot.revision > uploadedRevision)
+            {
+                vbo->write(slot.first * vertexSize, batch.vertices.data() + slot.first, slot.count * vertexSize);
+            }
+        }
+    }
+
+    vbo->release();
+    isUploaded       = true;
+    uploadedRevision = batch.revision;
+}
+
+void BatchPipe::draw(GLenum mode, GLint first, GLsizei count)
+{
+    if (count > 0)
+    {
+        glDrawArrays(mode, first, count);
+    }
+}
+
+void BatchPipe::setSelection(bool is_selection)
+{
+    program = is_selection && selectionProgram ? selectionProgram : drawProgram;
+}
+
+void BatchPipe::setRegion(int layer, const QVector4D& rect)
+{
+    // the disabled arrays take the current values of the attributes, the batch's vertices need no transformation
+    const Mat4 model;
+    const Mat3 normal;
+    for (GLuint column{0}; column < 4; ++column)
+    {
+        glVertexAttrib4fv(kModelLocation + column, model.constData() + column * 4);
+    }
+
+    for (GLuint column{0}; column < 3; ++column)
+    {
+        glVertexAttrib3fv(kNormalLocation + column, normal.constData() + column * 3);
+    }
+
+    glVertexAttrib4f(kAtlasRectLocation, rect.x(), rect.y(), rect.z(), rect.w());
+    glVertexAttrib1f(kAtlasLayerLocation, static_cast<float>(layer));
+}
+
+ScreenPipe::ScreenPipe(const Shader& shader, const Attributes& attributes) : Pipe(shader, nullptr, 0, attributes) {}
+
+void ScreenPipe::setViewport(const QSizeF& size)
+{
+    program->setUniformValue("viewport", size);
+}
+
+TextPipe::TextPipe(const Shader& shader, const Attributes& attributes) : ScreenPipe(shader, attributes) {}
+
+void TextPipe::setGlyphsUnit(uint unit)
+{
+    program->setUniformValue("glyphs", unit);
 }
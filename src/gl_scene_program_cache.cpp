@@ -0,0 +1,223 @@
+#include "gl_scene_program_cache.h"
+#include <QOpenGLContext>
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+using namespace gl_scene;
+
+namespace
+{
+
+const GLenum kProgramBinaryRetrievableHint{0x8257};
+const GLenum kProgramBinaryLength{0x8741};
+const GLuint kMaxCompilerThreads{0xFFFFFFFF};
+
+using MaxShaderCompilerThreads = void (*)(GLuint);
+
+QByteArray getShaderLog(QOpenGLExtraFunctions* functions, GLuint shader)
+{
+    GLint length{0};
+    functions->glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    QByteArray log(std::max(length, 1), '\0');
+    functions->glGetShaderInfoLog(shader, log.size(), nullptr, log.data());
+
+    return log;
+}
+
+QByteArray getProgramLog(QOpenGLExtraFunctions* functions, GLuint program)
+{
+    GLint length{0};
+    functions->glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+    QByteArray log(std::max(length, 1), '\0');
+    functions->glGetProgramInfoLog(program, log.size(), nullptr, log.data());
+
+    return log;
+}
+
+}  // namespace
+
+ProgramCache::ProgramCache(const QString& cache_dir) :
+    mFunctions(QOpenGLContext::currentContext()->extraFunctions()),
+    mCapabilities(Capabilities::detect()),
+    mCacheDir(cache_dir)
+{
+    auto* context = QOpenGLContext::currentContext();
+    if (mCapabilities.isParallelCompile)
+    {
+        const auto& maxThreads =
+            reinterpret_cast<MaxShaderCompilerThreads>(context->getProcAddress("glMaxShaderCompilerThreadsKHR"));
+        if (maxThreads != nullptr)
+        {
+            maxThreads(kMaxCompilerThreads);
+        }
+    }
+
+    // the binaries are valid for the same driver only
+    for (const auto& name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        mDriver.append(reinterpret_cast<const char*>(mFunctions->glGetString(name)));
+    }
+
+    mIsBinarySupported = !mCacheDir.isEmpty() && mCapabilities.isProgramBinary && QDir().mkpath(mCacheDir);
+}
+
+ProgramCache::Program ProgramCache::add(const Shader& source_shader, const std::string& defines)
+{
+    const Shader shader{mCapabilities.toShaderSource(source_shader.mVertex, defines),
+                        mCapabilities.toShaderSource(source_shader.mFragment, defines)};
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(mDriver);
+    hash.addData(shader.mVertex.c_str(), static_cast<int>(shader.mVertex.size()));
+    hash.addData(shader.mFragment.c_str(), static_cast<int>(shader.mFragment.size()));
+    const auto& key = hash.result().toHex();
+
+    const auto& entryPair = mEntries.find(key);
+    if (entryPair != mEntries.end())
+    {
+        return entryPair->second.program;
+    }
+
+    auto& entry    = mEntries[key];
+    entry.program  = std::make_shared<QOpenGLShaderProgram>();
+    entry.filename = mIsBinarySupported ? QDir(mCacheDir).filePath(QString::fromLatin1(key) + ".bin") : QString{};
+    entry.program->create();
+    if (!load(entry))
+    {
+        compile(entry, shader);
+    }
+
+    return entry.program;
+}
+
+void ProgramCache::finish()
+{
+    for (auto& entryPair : mEntries)
+    {
+        auto& entry = entryPair.second;
+        if (!entry.isPending)
+        {
+            continue;
+        }
+
+        // the logs are taken before the shaders are deleted, the failed program stays not linked for Qt
+        const auto& programId = entry.program->programId();
+        for (const auto& shader : entry.shaders)
+        {
+            GLint status{0};
+            mFunctions->glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+            if (status == 0)
+            {
+                qWarning() << "ProgramCache: the shader isn't compiled:"
+                           << getShaderLog(mFunctions, shader).constData();
+            }
+        }
+
+        GLint status{0};
+        mFunctions->glGetProgramiv(programId, GL_LINK_STATUS, &status);
+        if (status == 0)
+        {
+            qWarning() << "ProgramCache: the program isn't linked:"
+                       << getProgramLog(mFunctions, programId).constData();
+        }
+
+        for (const auto& shader : entry.shaders)
+        {
+            mFunctions->glDetachShader(programId, shader);
+            mFunctions->glDeleteShader(shader);
+        }
+        entry.shaders.clear();
+        entry.isPending = false;
+
+        // the program is linked already, so the link only marks it as linked for Qt
+        if (status != 0 && entry.program->link() && !entry.isLoaded)
+        {
+            store(entry);
+        }
+    }
+}
+
+bool ProgramCache::load(Entry& entry)
+{
+    QFile file(entry.filename);
+    if (entry.filename.isEmpty() || !file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    const auto& data = file.readAll();
+    if (data.size() <= static_cast<int>(sizeof(GLenum)))
+    {
+        return false;
+    }
+
+    GLenum format;
+    std::memcpy(&format, data.constData(), sizeof(GLenum));
+
+    // the driver could reject the binary (e.g. after the update), then the program is compiled
+    const auto& programId = entry.program->programId();
+    mFunctions->glProgramBinary(programId, format, data.constData() + sizeof(GLenum),
+                                data.size() - static_cast<int>(sizeof(GLenum)));
+
+    GLint status{0};
+    mFunctions->glGetProgramiv(programId, GL_LINK_STATUS, &status);
+    entry.isPending = status != 0;
+    entry.isLoaded  = status != 0;
+
+    return entry.isLoaded;
+}
+
+void ProgramCache::compile(Entry& entry, const Shader& shader)
+{
+    const auto& programId = entry.program->programId();
+    for (const auto& source : {std::make_pair(GL_VERTEX_SHADER, shader.mVertex.c_str()),
+                               std::make_pair(GL_FRAGMENT_SHADER, shader.mFragment.c_str())})
+    {
+        const auto& shaderId = mFunctions->glCreateShader(source.first);
+        mFunctions->glShaderSource(shaderId, 1, &source.second, nullptr);
+        mFunctions->glCompileShader(shaderId);
+        mFunctions->glAttachShader(programId, shaderId);
+        entry.shaders.push_back(shaderId);
+    }
+
+    // the status isn't queried here, so the driver isn't forced to finish the build
+    if (mIsBinarySupported)
+    {
+        mFunctions->glProgramParameteri(programId, kProgramBinaryRetrievableHint, GL_TRUE);
+    }
+    mFunctions->glLinkProgram(programId);
+    entry.isPending = true;
+    entry.isLoaded  = false;
+}
+
+void ProgramCache::store(const Entry& entry)
+{
+    if (entry.filename.isEmpty())
+    {
+        return;
+    }
+
+    const auto& programId = entry.program->programId();
+    GLint length{0};
+    mFunctions->glGetProgramiv(programId, kProgramBinaryLength, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    QByteArray data(static_cast<int>(sizeof(GLenum)) + length, Qt::Uninitialized);
+    GLenum format{0};
+    mFunctions->glGetProgramBinary(programId, length, nullptr, &format, data.data() + sizeof(GLenum));
+    std::memcpy(data.data(), &format, sizeof(GLenum));
+
+    QSaveFile file(entry.filename);
+    if (file.open(QIODevice::WriteOnly) && file.write(data) == data.size())
+    {
+        file.commit();
+    }
+}
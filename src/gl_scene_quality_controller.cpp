@@ -0,0 +1,51 @@
+#include "gl_scene_quality_controller.h"
+
+using namespace gl_scene;
+
+namespace
+{
+
+// the quality is raised when the frames are faster than the part of the target time for a while, so it doesn't swing
+const float kRaiseRatio{0.5f};
+const int kRaiseFrameCount{10};
+
+}  // namespace
+
+QualityController::QualityController(float target_frame_time, const QualityLevel::Pack& levels) :
+    mTargetFrameTime(target_frame_time),
+    mLevels(levels.empty() ? QualityLevel::Pack{{0, 1.0f, true}} : levels)
+{}
+
+const QualityLevel& QualityController::beginFrame(bool is_interacting)
+{
+    mIsInteracting = is_interacting;
+    if (!mIsInteracting && mLevel > 0)
+    {
+        mLevel--;
+        mFastFrameCount = 0;
+    }
+
+    return mLevels[mLevel];
+}
+
+void QualityController::addFrameTime(float frame_time)
+{
+    if (!mIsInteracting)
+    {
+        return;
+    }
+
+    if (frame_time > mTargetFrameTime)
+    {
+        mFastFrameCount = 0;
+        if (mLevel + 1 < mLevels.size())
+        {
+            mLevel++;
+        }
+    }
+    else if (frame_time < mTargetFrameTime * kRaiseRatio && mLevel > 0 && ++mFastFrameCount >= kRaiseFrameCount)
+    {
+        mFastFrameCount = 0;
+        mLevel--;
+    }
+}
@@ -0,0 +1,125 @@
+#include "gl_scene_resource_manager.h"
+#include <algorithm>
+
+using namespace gl_scene;
+
+namespace
+{
+
+// the managers are owned by the views, the registry only finds them
+std::map<std::pair<const QOpenGLContextGroup*, const Scene*>, std::weak_ptr<ResourceManager>> registry;
+
+// the shaders take the item's data from the per draw attributes (the indirect draws and the batches)
+const std::string kIndirectDefines{"#define SCENE_INDIRECT\n"};
+
+}  // namespace
+
+ResourceManager::Ptr ResourceManager::acquire(const Scene::Ptr& scene, const QString& cache_dir, bool is_compressed,
+                                              const QString& program_cache_dir)
+{
+    const auto* context = QOpenGLContext::currentContext();
+    if (context == nullptr || !scene)
+    {
+        return nullptr;
+    }
+
+    const Key key{context->shareGroup(), scene.get()};
+    auto manager = registry[key].lock();
+    if (!manager)
+    {
+        manager       = Ptr(new ResourceManager(key, scene, cache_dir, is_compressed, program_cache_dir));
+        registry[key] = manager;
+    }
+
+    return manager;
+}
+
+ResourceManager::ResourceManager(const Key& key, const Scene::Ptr& scene, const QString& cache_dir,
+                                 bool is_compressed, const QString& program_cache_dir) :
+    mKey(key)
+{
+    // the static geometry of all pipes is uploaded into the same buffers, the pipes differ by the program only
+    const auto& geometry = Pipe::makeBuffers(scene->getVertexSegments(), scene->getIndexSegments());
+
+    // all programs are started before any of them is waited for, the same sources share the program
+    ProgramCache programCache(program_cache_dir);
+    const auto& capabilities = Capabilities::detect();
+    for (const auto& shaderPair : scene->getShaders())
+    {
+        mResources[shaderPair.first] = {programCache.add(shaderPair.second), geometry.vbo, geometry.ibo};
+
+        // the per draw attributes' programs are used by the frozen items' batches even without the indirect draws
+        mIndirectResources[shaderPair.first] = {programCache.add(shaderPair.second, kIndirectDefines), geometry.vbo,
+                                                geometry.ibo};
+    }
+    programCache.finish();
+
+    // the pipes aren't created for the failed per draw attributes' programs, the items of such indirect pipes and
+    // batches are drawn by their own calls then
+    for (auto& resourcesPair : mIndirectResources)
+    {
+        auto& program = resourcesPair.second.program;
+        if (program && !program->isLinked())
+        {
+            program.reset();
+        }
+    }
+
+    // the indirect draws are culled on the CPU if the culling program isn't built
+    if (capabilities.isMultiDrawIndirect && capabilities.isCompute)
+    {
+        const auto& source = QString::fromStdString(capabilities.toShaderSource(defaults::shaders::kCulling));
+        auto program       = std::make_shared<QOpenGLShaderProgram>();
+        if (program->addShaderFromSourceCode(QOpenGLShader::Compute, source) && program->link())
+        {
+            mCullingProgram = program;
+        }
+    }
+
+    mTextureManager = std::make_shared<TextureManager>(scene->getTextures(), cache_dir, is_compressed);
+    mTextureManager->setReadyCallback([this]() {
+        std::lock_guard<std::mutex> lock(mCallbacksMutex);
+        for (const auto& callbackPair : mCallbacks)
+        {
+            callbackPair.second();
+        }
+    });
+}
+
+ResourceManager::~ResourceManager()
+{
+    // the workers could still decode the textures, they mustn't call back into the destroyed manager
+    mTextureManager->setReadyCallback(nullptr);
+
+    const auto& managerPair = registry.find(mKey);
+    if (managerPair != registry.end() && managerPair->second.expired())
+    {
+        registry.erase(managerPair);
+    }
+}
+
+void ResourceManager::addReadyCallback(const void* owner, const ReadyCallback& callback)
+{
+    std::lock_guard<std::mutex> lock(mCallbacksMutex);
+    mCallbacks.emplace_back(owner, callback);
+}
+
+void ResourceManager::removeReadyCallback(const void* owner)
+{
+    std::lock_guard<std::mutex> lock(mCallbacksMutex);
+    mCallbacks.erase(std::remove_if(mCallbacks.begin(), mCallbacks.end(),
+                                    [owner](const auto& callbackPair) { return callbackPair.first == owner; }),
+                     mCallbacks.end());
+}
+
+const Pipe::Resources& ResourceManager::getResources(PipeID pipe_id) const
+{
+    const auto& resourcesPair = mResources.find(pipe_id);
+    return resourcesPair != mResources.cend() ? resourcesPair->second : mEmpty;
+}
+
+const Pipe::Resources& ResourceManager::getIndirectResources(PipeID pipe_id) const
+{
+    const auto& resourcesPair = mIndirectResources.find(pipe_id);
+    return resourcesPair != mIndirectResources.cend() ? resourcesPair->second : mEmpty;
+}
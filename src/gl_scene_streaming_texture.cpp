@@ -0,0 +1,211 @@
+#include "gl_scene_streaming_texture.h"
+#include <QOpenGLFunctions>
+#include <QOpenGLContext>
+#include <algorithm>
+#include <cstring>
+
+using namespace gl_scene;
+
+StreamingTexture::StreamingTexture(int width, int height) :
+    mWidth(width),
+    mHeight(height),
+    mSize(width * height * 4),
+    mTexture(std::make_shared<QOpenGLTexture>(QOpenGLTexture::Target2D))
+{}
+
+bool StreamingTexture::pushFrame(const QImage& frame)
+{
+    if (frame.width() != mWidth || frame.height() != mHeight)
+    {
+        mDroppedCount++;
+        return false;
+    }
+
+    const auto& image =
+        frame.format() == QImage::Format_RGBA8888 ? frame : frame.convertToFormat(QImage::Format_RGBA8888);
+
+    Slot* target{nullptr};
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& slot : mSlots)
+        {
+            if (slot.state == SlotState::kFree)
+            {
+                target = &slot;
+                break;
+            }
+        }
+
+        // the render thread is behind, the oldest not uploaded frame is replaced
+        if (target == nullptr)
+        {
+            for (auto& slot : mSlots)
+            {
+                if (slot.state == SlotState::kFilled && (target == nullptr || slot.frame < target->frame))
+                {
+                    target = &slot;
+                }
+            }
+
+            if (target == nullptr)
+            {
+                mDroppedCount++;
+                return false;
+            }
+
+            mDroppedCount++;
+        }
+
+        target->state = SlotState::kWriting;
+    }
+
+    // the rows are copied bottom up, so the texture gets the OpenGL orientation without mirroring
+    const auto& rowSize = mWidth * 4;
+    for (int y{0}; y < mHeight; ++y)
+    {
+        std::memcpy(target->data + (mHeight - 1 - y) * rowSize, image.constScanLine(y), static_cast<size_t>(rowSize));
+    }
+
+    // the callback is called without the lock, but the destroy waits for it, so its owner isn't destroyed meanwhile
+    ReadyCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        target->state = SlotState::kFilled;
+        target->frame = ++mFrame;
+        callback      = mCallback;
+        if (callback)
+        {
+            mCallingCount++;
+        }
+    }
+
+    mWritten.notify_all();
+    if (callback)
+    {
+        callback();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCallingCount--;
+        mWritten.notify_all();
+    }
+
+    return true;
+}
+
+bool StreamingTexture::upload()
+{
+    if (!mTexture->isCreated())
+    {
+        mTexture->setSize(mWidth, mHeight);
+        mTexture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+        mTexture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+        mTexture->setMinificationFilter(QOpenGLTexture::Linear);
+        mTexture->setMagnificationFilter(QOpenGLTexture::Linear);
+        mTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+        for (auto& slot : mSlots)
+        {
+            slot.buffer.create();
+            slot.buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+        }
+    }
+
+    Slot* filled{nullptr};
+    std::vector<Slot*> unmapped;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& slot : mSlots)
+        {
+            if (slot.state == SlotState::kFilled && (filled == nullptr || slot.frame > filled->frame))
+            {
+                filled = &slot;
+            }
+        }
+
+        for (auto& slot : mSlots)
+        {
+            if (slot.state == SlotState::kFilled && &slot != filled)
+            {
+                slot.state = SlotState::kFree;
+                mDroppedCount++;
+            }
+            else if (slot.state == SlotState::kUnmapped || &slot == filled)
+            {
+                slot.state = SlotState::kUnmapped;
+                unmapped.push_back(&slot);
+            }
+        }
+    }
+
+    if (filled != nullptr)
+    {
+        // the transfer is performed by the driver asynchronously, the data is sourced from the bound buffer
+        filled->buffer.bind();
+        filled->buffer.unmap();
+        mTexture->bind();
+        QOpenGLContext::currentContext()->functions()->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mWidth, mHeight, GL_RGBA,
+                                                                       GL_UNSIGNED_BYTE, nullptr);
+        mTexture->release();
+        filled->buffer.release();
+    }
+
+    // the buffers are orphaned before mapping, so the pending transfers don't stall the mapping
+    for (auto* slot : unmapped)
+    {
+        auto* data = map(*slot);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        slot->data  = data;
+        slot->state = data != nullptr ? SlotState::kFree : SlotState::kUnmapped;
+    }
+
+    return filled != nullptr;
+}
+
+void StreamingTexture::destroy()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCallback = nullptr;
+    mWritten.wait(lock, [this]() {
+        return mCallingCount == 0 && std::none_of(mSlots.begin(), mSlots.end(), [](const Slot& slot) {
+                   return slot.state == SlotState::kWriting;
+               });
+    });
+
+    for (auto& slot : mSlots)
+    {
+        if (slot.buffer.isCreated())
+        {
+            if (slot.state != SlotState::kUnmapped)
+            {
+                slot.buffer.bind();
+                slot.buffer.unmap();
+                slot.buffer.release();
+            }
+            slot.buffer.destroy();
+        }
+
+        slot.data  = nullptr;
+        slot.state = SlotState::kUnmapped;
+    }
+
+    mTexture->destroy();
+}
+
+void StreamingTexture::setReadyCallback(const ReadyCallback& callback)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCallback = callback;
+    mWritten.wait(lock, [this]() { return mCallingCount == 0; });
+}
+
+uchar* StreamingTexture::map(Slot& slot)
+{
+    slot.buffer.bind();
+    slot.buffer.allocate(mSize);
+    auto* data = static_cast<uchar*>(
+        slot.buffer.mapRange(0, mSize, QOpenGLBuffer::RangeWrite | QOpenGLBuffer::RangeInvalidateBuffer));
+    slot.buffer.release();
+
+    return data;
+}
@@ -0,0 +1,240 @@
+#include "gl_scene_text_renderer.h"
+#include "gl_scene_defaults.h"
+#include "gl_scene_utility.h"
+#include <QOpenGLContext>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+using namespace gl_scene;
+
+namespace
+{
+
+const int kAtlasSize{1024};
+const int kGlyphPadding{1};
+const size_t kMaxLayouts{4096};
+
+}  // namespace
+
+TextRenderer::TextRenderer() :
+    mPipe(std::make_shared<TextPipe>(defaults::shaders::kText, defaults::pipes::kTextAttributes)),
+    mAtlas(std::make_shared<QOpenGLTexture>(QOpenGLTexture::Target2D))
+{
+    mAtlas->setSize(kAtlasSize, kAtlasSize);
+    mAtlas->setFormat(QOpenGLTexture::R8_UNorm);
+    mAtlas->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
+    mAtlas->setMinificationFilter(QOpenGLTexture::Linear);
+    mAtlas->setMagnificationFilter(QOpenGLTexture::Linear);
+    mAtlas->setWrapMode(QOpenGLTexture::ClampToEdge);
+    resetAtlas();
+}
+
+void TextRenderer::render(const LabelPlacer::Label::Pack& labels, const QSize& size, qreal pixel_ratio)
+{
+    build(labels, pixel_ratio);
+
+    // the atlas is rebuilt from scratch by the glyphs of the current frame only
+    if (mIsAtlasFull)
+    {
+        resetAtlas();
+        build(labels, pixel_ratio);
+    }
+
+    if (mVertices.empty())
+    {
+        return;
+    }
+
+    const auto& indexCount = static_cast<int>(mVertices.size() / 4 * 6);
+
+    mPipe->bind();
+
+    // the quads' indices don't depend on the text, so they are uploaded only when the amount of glyphs grows
+    if (mIndexCount < indexCount)
+    {
+        const auto& indexSize = static_cast<size_t>(indexCount);
+        for (auto base = static_cast<GLuint>(mIndices.size() / 6 * 4); mIndices.size() < indexSize; base += 4)
+        {
+            mIndices.insert(mIndices.end(), {base, base + 1, base + 2, base + 2, base + 1, base + 3});
+        }
+
+        mPipe->allocateIndices(mIndices.data(), indexCount * static_cast<int>(sizeof(GLuint)));
+        mIndexCount = indexCount;
+    }
+
+    mPipe->allocate(mVertices.data(), static_cast<int>(mVertices.size() * sizeof(Vertex)));
+    mPipe->setViewport(QSizeF(size) * pixel_ratio);
+    mPipe->setGlyphsUnit(0);
+    mAtlas->bind(0);
+    mPipe->glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
+    mAtlas->release();
+    mPipe->release();
+}
+
+void TextRenderer::update(const TextItem::Pack& items, const std::vector<uint64_t>& revisions, qreal pixel_ratio)
+{
+    // the layouts of the texts gone from the scene are dropped as a whole, so all items are resolved again
+    if (mPixelRatio != pixel_ratio || mLayouts.size() > std::max(kMaxLayouts, items.size() * 2))
+    {
+        mLayouts.clear();
+        mItemLayouts.clear();
+        mItemRevisions.clear();
+        mPixelRatio = pixel_ratio;
+    }
+
+    mItemLayouts.resize(items.size(), nullptr);
+    mItemRevisions.resize(items.size(), 0);
+    for (size_t index{0}; index < items.size(); ++index)
+    {
+        if (mItemRevisions[index] != revisions[index] || mItemLayouts[index] == nullptr)
+        {
+            mItemLayouts[index]   = &getLayout(items[index], pixel_ratio);
+            mItemRevisions[index] = revisions[index];
+        }
+    }
+}
+
+void TextRenderer::build(const LabelPlacer::Label::Pack& labels, qreal pixel_ratio)
+{
+    mVertices.clear();
+    mIsAtlasFull = false;
+
+    for (const auto& label : labels)
+    {
+        const auto& item   = *label.item;
+        const auto& layout = *mItemLayouts[label.index];
+
+        const auto& r = static_cast<float>(item.color.redF());
+        const auto& g = static_cast<float>(item.color.greenF());
+        const auto& b = static_cast<float>(item.color.blueF());
+        const auto& a = static_cast<float>(item.color.alphaF());
+
+        auto penX       = std::round(label.origin.x() * pixel_ratio);
+        const auto penY = std::round(label.origin.y() * pixel_ratio);
+        for (int i{0}; i < layout.glyphIndexes.size(); ++i)
+        {
+            // the glyph not fitting the atlas is skipped, the rest of the labels are still drawn
+            const auto* glyph = getGlyph(*layout.font, layout.glyphIndexes[i]);
+            if (glyph != nullptr && !glyph->rect.isEmpty())
+            {
+                const auto& rect = glyph->rect.translated(penX, penY);
+                const auto& uv   = glyph->uv;
+                const auto& l    = static_cast<float>(rect.left());
+                const auto& t    = static_cast<float>(rect.top());
+                const auto& rt   = static_cast<float>(rect.right());
+                const auto& bm   = static_cast<float>(rect.bottom());
+                const auto& ul   = static_cast<float>(uv.left());
+                const auto& ut   = static_cast<float>(uv.top());
+                const auto& ur   = static_cast<float>(uv.right());
+                const auto& ub   = static_cast<float>(uv.bottom());
+
+                mVertices.push_back({l, t, ul, ut, r, g, b, a});
+                mVertices.push_back({l, bm, ul, ub, r, g, b, a});
+                mVertices.push_back({rt, t, ur, ut, r, g, b, a});
+                mVertices.push_back({rt, bm, ur, ub, r, g, b, a});
+            }
+
+            penX += layout.advances[i].x();
+        }
+    }
+}
+
+TextRenderer::Font& TextRenderer::getFont(const QFont& font, qreal pixel_ratio)
+{
+    const auto& key = font.key() + QString::number(pixel_ratio);
+    auto fontPair   = mFonts.find(key);
+    if (fontPair != mFonts.end())
+    {
+        return fontPair->second;
+    }
+
+    auto raw = QRawFont::fromFont(font);
+    raw.setPixelSize(raw.pixelSize() * pixel_ratio);
+
+    return mFonts.emplace(key, Font{raw, {}}).first->second;
+}
+
+const TextRenderer::Layout& TextRenderer::getLayout(const TextItem& item, qreal pixel_ratio)
+{
+    const auto& key = std::make_pair(item.font.key() + QString::number(pixel_ratio), item.text);
+    auto layoutPair = mLayouts.find(key);
+    if (layoutPair != mLayouts.end())
+    {
+        return layoutPair->second;
+    }
+
+    Layout layout;
+    layout.font         = &getFont(item.font, pixel_ratio);
+    layout.glyphIndexes = layout.font->raw.glyphIndexesForString(item.text);
+    layout.advances     = layout.font->raw.advancesForGlyphIndexes(layout.glyphIndexes);
+
+    qreal textWidth{0.0};
+    for (const auto& advance : layout.advances)
+    {
+        textWidth += advance.x();
+    }
+
+    const auto& ascent = static_cast<int>(layout.font->raw.ascent() / pixel_ratio);
+    const auto& height = static_cast<int>((layout.font->raw.ascent() + layout.font->raw.descent()) / pixel_ratio);
+    layout.bounds      = {0, -ascent, static_cast<int>(textWidth / pixel_ratio), height};
+
+    return mLayouts.emplace(key, layout).first->second;
+}
+
+const TextRenderer::Glyph* TextRenderer::getGlyph(Font& font, quint32 glyph_index)
+{
+    auto glyphPair = font.glyphs.find(glyph_index);
+    if (glyphPair != font.glyphs.end())
+    {
+        return &glyphPair->second;
+    }
+
+    Glyph glyph;
+    const auto& path   = font.raw.pathForGlyph(glyph_index);
+    const auto& bounds = path.boundingRect().toAlignedRect();
+    if (!bounds.isEmpty())
+    {
+        // the glyph is rasterized from its outline, so its position relative to the baseline is exact
+        QImage image(bounds.size() + QSize{kGlyphPadding * 2, kGlyphPadding * 2}, QImage::Format_Alpha8);
+        image.fill(0);
+
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.translate(kGlyphPadding - bounds.x(), kGlyphPadding - bounds.y());
+        painter.fillPath(path, Qt::black);
+        painter.end();
+
+        QPoint position;
+        if (!packShelf(mShelves, kAtlasSize, image.size(), position))
+        {
+            mIsAtlasFull = true;
+            return nullptr;
+        }
+
+        mAtlas->bind();
+        QOpenGLContext::currentContext()->functions()->glTexSubImage2D(GL_TEXTURE_2D, 0, position.x(), position.y(),
+                                                                       image.width(), image.height(), GL_RED,
+                                                                       GL_UNSIGNED_BYTE, image.constBits());
+        mAtlas->release();
+
+        const auto& scale = 1.0 / kAtlasSize;
+        glyph.rect        = {bounds.topLeft() - QPoint{kGlyphPadding, kGlyphPadding}, QSizeF(image.size())};
+        glyph.uv = {position.x() * scale, position.y() * scale, image.width() * scale, image.height() * scale};
+    }
+
+    return &(font.glyphs[glyph_index] = glyph);
+}
+
+void TextRenderer::resetAtlas()
+{
+    mShelves.clear();
+    for (auto& fontPair : mFonts)
+    {
+        fontPair.second.glyphs.clear();
+    }
+
+    // the glyphs are sampled with the bilinear filter, so the space around them must be empty
+    const std::vector<uchar> zeros(kAtlasSize * kAtlasSize, 0);
+    mAtlas->setData(QOpenGLTexture::Red, QOpenGLTexture::UInt8, zeros.data());
+}
@@ -0,0 +1,343 @@
+#include "gl_scene_texture_cache.h"
+#include "gl_scene_utility.h"
+#include <QSaveFile>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+
+using namespace gl_scene;
+
+namespace
+{
+
+const uint8_t kIdentifier[12]{0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+const uint32_t kEndianness{0x04030201};
+const uint32_t kUnsignedByte{0x1401};
+const uint32_t kRGB{0x1907};
+const uint32_t kRGBA{0x1908};
+const uint32_t kRGBA8{0x8058};
+const uint32_t kRGBDXT1{0x83F0};
+const int kBlockSize{4};
+const int kBlockBytes{8};
+
+struct FileHeader
+{
+    uint8_t identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+uint64_t levelSize(uint64_t width, uint64_t height, bool is_compressed)
+{
+    if (is_compressed)
+    {
+        return (width + kBlockSize - 1) / kBlockSize * ((height + kBlockSize - 1) / kBlockSize) * kBlockBytes;
+    }
+
+    return width * height * 4;
+}
+
+bool isOpaque(const QImage& image)
+{
+    for (int y{0}; y < image.height(); ++y)
+    {
+        const auto* line = image.constScanLine(y);
+        for (int x{0}; x < image.width(); ++x)
+        {
+            if (line[x * 4 + 3] != 0xFF)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// the next mip level is built by the 2x2 box filter
+QImage downsample(const QImage& image)
+{
+    QImage result(std::max(1, image.width() / 2), std::max(1, image.height() / 2), QImage::Format_RGBA8888);
+    for (int y{0}; y < result.height(); ++y)
+    {
+        const auto* line0 = image.constScanLine(std::min(y * 2, image.height() - 1));
+        const auto* line1 = image.constScanLine(std::min(y * 2 + 1, image.height() - 1));
+        auto* target      = result.scanLine(y);
+        for (int x{0}; x < result.width(); ++x)
+        {
+            const auto& x0 = std::min(x * 2, image.width() - 1) * 4;
+            const auto& x1 = std::min(x * 2 + 1, image.width() - 1) * 4;
+            for (int c{0}; c < 4; ++c)
+            {
+                const auto& sum   = line0[x0 + c] + line0[x1 + c] + line1[x0 + c] + line1[x1 + c];
+                target[x * 4 + c] = static_cast<uchar>((sum + 2) / 4);
+            }
+        }
+    }
+
+    return result;
+}
+
+uint16_t to565(const int* color)
+{
+    return static_cast<uint16_t>(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 |
+                                 ((color[2] * 31 + 127) / 255));
+}
+
+void from565(uint16_t value, int* color)
+{
+    const int r{(value >> 11) & 31};
+    const int g{(value >> 5) & 63};
+    const int b{value & 31};
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// the endpoints are the corners of the colors' bounding box (inset by 1/16 of its size), the diagonal is chosen by the
+// signs of the channels' covariance
+void compressBlock(const QImage& image, int block_x, int block_y, uchar* out)
+{
+    int pixels[16][3];
+    int mean[3]{0, 0, 0};
+    for (int y{0}; y < kBlockSize; ++y)
+    {
+        const auto* line = image.constScanLine(std::min(block_y + y, image.height() - 1));
+        for (int x{0}; x < kBlockSize; ++x)
+        {
+            const auto* pixel = line + std::min(block_x + x, image.width() - 1) * 4;
+            for (int c{0}; c < 3; ++c)
+            {
+                pixels[y * kBlockSize + x][c] = pixel[c];
+                mean[c] += pixel[c];
+            }
+        }
+    }
+
+    int minColor[3]{255, 255, 255};
+    int maxColor[3]{0, 0, 0};
+    int covariance[3]{0, 0, 0};
+    for (const auto& pixel : pixels)
+    {
+        for (int c{0}; c < 3; ++c)
+        {
+            minColor[c] = std::min(minColor[c], pixel[c]);
+            maxColor[c] = std::max(maxColor[c], pixel[c]);
+            covariance[c] += (pixel[0] * 16 - mean[0]) * (pixel[c] * 16 - mean[c]);
+        }
+    }
+
+    for (int c{0}; c < 3; ++c)
+    {
+        const auto& inset = (maxColor[c] - minColor[c]) / 16;
+        minColor[c] += inset;
+        maxColor[c] -= inset;
+        if (covariance[c] < 0)
+        {
+            std::swap(minColor[c], maxColor[c]);
+        }
+    }
+
+    auto color0 = to565(maxColor);
+    auto color1 = to565(minColor);
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    int palette[4][3];
+    from565(color0, palette[0]);
+    from565(color1, palette[1]);
+    for (int c{0}; c < 3; ++c)
+    {
+        // equal endpoints switch the block into the three colors mode, so the first color is used only
+        palette[2][c] = color0 > color1 ? (palette[0][c] * 2 + palette[1][c]) / 3 : palette[0][c];
+        palette[3][c] = color0 > color1 ? (palette[0][c] + palette[1][c] * 2) / 3 : palette[0][c];
+    }
+
+    uint32_t indices{0};
+    for (int i{0}; i < 16; ++i)
+    {
+        int best{0};
+        int bestDistance{std::numeric_limits<int>::max()};
+        for (int p{0}; p < 4; ++p)
+        {
+            int distance{0};
+            for (int c{0}; c < 3; ++c)
+            {
+                const auto& delta = pixels[i][c] - palette[p][c];
+                distance += delta * delta;
+            }
+
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                best         = p;
+            }
+        }
+
+        indices |= static_cast<uint32_t>(best) << (i * 2);
+    }
+
+    out[0] = static_cast<uchar>(color0 & 0xFF);
+    out[1] = static_cast<uchar>(color0 >> 8);
+    out[2] = static_cast<uchar>(color1 & 0xFF);
+    out[3] = static_cast<uchar>(color1 >> 8);
+    for (int i{0}; i < 4; ++i)
+    {
+        out[4 + i] = static_cast<uchar>(indices >> (i * 8));
+    }
+}
+
+QByteArray compress(const QImage& image)
+{
+    QByteArray data(static_cast<int>(levelSize(image.width(), image.height(), true)), '\0');
+    auto* out = reinterpret_cast<uchar*>(data.data());
+    for (int y{0}; y < image.height(); y += kBlockSize)
+    {
+        for (int x{0}; x < image.width(); x += kBlockSize)
+        {
+            compressBlock(image, x, y, out);
+            out += kBlockBytes;
+        }
+    }
+
+    return data;
+}
+
+}  // namespace
+
+TextureCache::Ptr TextureCache::open(const QString& filename)
+{
+    Ptr cache(new TextureCache);
+    cache->mFile.setFileName(filename);
+    if (!cache->mFile.open(QIODevice::ReadOnly))
+    {
+        return {};
+    }
+
+    const auto& fileSize = static_cast<uint64_t>(cache->mFile.size());
+    if (fileSize < sizeof(FileHeader))
+    {
+        return {};
+    }
+
+    const uchar* data = cache->mFile.map(0, cache->mFile.size());
+    if (data == nullptr)
+    {
+        return {};
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(FileHeader));
+    const auto& isCompressed = header.glInternalFormat == kRGBDXT1;
+    if (std::memcmp(header.identifier, kIdentifier, sizeof(kIdentifier)) != 0 || header.endianness != kEndianness ||
+        (!isCompressed && (header.glInternalFormat != kRGBA8 || header.glType != kUnsignedByte)) ||
+        header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth != 0 ||
+        header.numberOfArrayElements != 0 || header.numberOfFaces != 1 || header.numberOfMipmapLevels == 0)
+    {
+        return {};
+    }
+
+    uint64_t offset{sizeof(FileHeader) + static_cast<uint64_t>(header.bytesOfKeyValueData)};
+    uint32_t width{header.pixelWidth};
+    uint32_t height{header.pixelHeight};
+    for (uint32_t i{0}; i < header.numberOfMipmapLevels; ++i)
+    {
+        uint32_t size;
+        if (offset + sizeof(size) > fileSize)
+        {
+            return {};
+        }
+
+        std::memcpy(&size, data + offset, sizeof(size));
+        offset += sizeof(size);
+        if (size != levelSize(width, height, isCompressed) || size > fileSize - offset)
+        {
+            return {};
+        }
+
+        cache->mLevels.push_back(
+            {static_cast<int>(width), static_cast<int>(height), data + offset, static_cast<int>(size)});
+
+        // the levels are aligned to 4 bytes
+        offset += (static_cast<uint64_t>(size) + 3) / 4 * 4;
+        width  = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+
+    cache->mIsCompressed = isCompressed;
+    return cache;
+}
+
+bool TextureCache::write(const QString& filename, const QImage& image, bool is_compressed)
+{
+    if (image.isNull())
+    {
+        return false;
+    }
+
+    std::vector<QImage> levels{image.convertToFormat(QImage::Format_RGBA8888)};
+    while (levels.back().width() > 1 || levels.back().height() > 1)
+    {
+        levels.push_back(downsample(levels.back()));
+    }
+
+    const auto& isBlockCompressed = is_compressed && isOpaque(levels.front());
+
+    FileHeader header{};
+    std::memcpy(header.identifier, kIdentifier, sizeof(kIdentifier));
+    header.endianness           = kEndianness;
+    header.glType               = isBlockCompressed ? 0 : kUnsignedByte;
+    header.glTypeSize           = 1;
+    header.glFormat             = isBlockCompressed ? 0 : kRGBA;
+    header.glInternalFormat     = isBlockCompressed ? kRGBDXT1 : kRGBA8;
+    header.glBaseInternalFormat = isBlockCompressed ? kRGB : kRGBA;
+    header.pixelWidth           = static_cast<uint32_t>(image.width());
+    header.pixelHeight          = static_cast<uint32_t>(image.height());
+    header.numberOfFaces        = 1;
+    header.numberOfMipmapLevels = static_cast<uint32_t>(levels.size());
+
+    // the container is written into the temporary file and replaces the old one on commit
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    bool isWritten = file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader)) == sizeof(FileHeader);
+    for (const auto& level : levels)
+    {
+        const auto* bits = reinterpret_cast<const char*>(level.constBits());
+        const auto& data = isBlockCompressed ? compress(level) :
+                                               QByteArray::fromRawData(bits, static_cast<int>(level.sizeInBytes()));
+        const auto& size = static_cast<uint32_t>(data.size());
+
+        isWritten = isWritten && file.write(reinterpret_cast<const char*>(&size), sizeof(size)) == sizeof(size) &&
+            file.write(data) == data.size();
+    }
+
+    if (!isWritten)
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+QString TextureCache::cacheFilename(const QString& source_filename, bool is_compressed, const QString& cache_dir)
+{
+    return gl_scene::cacheFilename(source_filename, cache_dir, is_compressed ? "bc1.ktx" : "ktx");
+}
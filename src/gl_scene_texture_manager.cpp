@@ -0,0 +1,303 @@
+#include "gl_scene_texture_manager.h"
+#include "gl_scene_utility.h"
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLContext>
+#include <QtConcurrent>
+#include <algorithm>
+
+using namespace gl_scene;
+
+namespace
+{
+
+const int kAtlasSize{1024};
+const int kAtlasLayers{4};
+const int kAtlasMaxImageSize{256};
+const int kAtlasPadding{8};
+// the padding stays at least one texel wide on the last mip level
+const int kAtlasMipLevels{4};
+
+// the image is surrounded by the padding filled with its edge texels, so filtering doesn't bleed the neighbours
+QImage padImage(const QImage& image)
+{
+    QImage padded(image.width() + kAtlasPadding * 2, image.height() + kAtlasPadding * 2, QImage::Format_RGBA8888);
+    for (int y{0}; y < padded.height(); ++y)
+    {
+        const auto& sourceY = std::clamp(y - kAtlasPadding, 0, image.height() - 1);
+        const auto* source  = reinterpret_cast<const uint32_t*>(image.constScanLine(sourceY));
+        auto* target        = reinterpret_cast<uint32_t*>(padded.scanLine(y));
+        for (int x{0}; x < padded.width(); ++x)
+        {
+            target[x] = source[std::clamp(x - kAtlasPadding, 0, image.width() - 1)];
+        }
+    }
+
+    return padded;
+}
+
+}  // namespace
+
+TextureManager::TextureManager(const TexturesMap& textures_map, const QString& cache_dir, bool is_compressed) :
+    mCacheDir(cache_dir),
+    mIsCompressed(is_compressed),
+    mQueue(std::make_shared<DecodedQueue>())
+{
+    for (const auto& texturePair : textures_map)
+    {
+        const auto& texture         = texturePair.second;
+        const auto& state           = texture.data ? State::kReady : State::kIdle;
+        mEntries[texturePair.first] = {texture.filename, texture.isAtlased, state, {texture.data}};
+    }
+}
+
+TextureManager::~TextureManager()
+{
+    std::lock_guard<std::mutex> lock(mQueue->mutex);
+    mQueue->callback = nullptr;
+}
+
+const TextureManager::Region& TextureManager::get(TextureID texture_id)
+{
+    auto entryPair = mEntries.find(texture_id);
+    if (entryPair == mEntries.end())
+    {
+        return mEmpty;
+    }
+
+    auto& entry = entryPair->second;
+    if (entry.state == State::kReady)
+    {
+        return entry.region;
+    }
+
+    if (entry.state == State::kIdle)
+    {
+        entry.state = State::kLoading;
+        load(texture_id, entry.filename, entry.isAtlased);
+    }
+
+    return getPlaceholder();
+}
+
+bool TextureManager::upload(qint64 byte_budget)
+{
+    qint64 bytes{0};
+    bool isLeft{false};
+    while (bytes < byte_budget)
+    {
+        // the cached textures being refined go first, they are visible already
+        if (!mPendingLevels.empty())
+        {
+            bytes += uploadLevel(mPendingLevels.front());
+            continue;
+        }
+
+        DecodedImage decoded;
+        {
+            std::lock_guard<std::mutex> lock(mQueue->mutex);
+            if (mQueue->images.empty())
+            {
+                break;
+            }
+
+            decoded = std::move(mQueue->images.front());
+            mQueue->images.pop_front();
+            isLeft = !mQueue->images.empty();
+        }
+
+        mLoadingCount--;
+        auto& entry = mEntries[decoded.textureId];
+        if (decoded.cache)
+        {
+            const auto& levels = decoded.cache->getLevels();
+            auto data          = std::make_shared<QOpenGLTexture>(QOpenGLTexture::Target2D);
+            data->setSize(levels.front().width, levels.front().height);
+            data->setFormat(decoded.cache->isCompressed() ? QOpenGLTexture::RGB_DXT1 : QOpenGLTexture::RGBA8_UNorm);
+            data->setMipLevels(static_cast<int>(levels.size()));
+            data->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+            data->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+            data->setMagnificationFilter(QOpenGLTexture::Linear);
+
+            entry.region = {data};
+            entry.cache  = decoded.cache;
+            entry.level  = static_cast<int>(levels.size()) - 1;
+            mPendingLevels.push_back(decoded.textureId);
+            continue;
+        }
+
+        if (decoded.image.isNull())
+        {
+            entry.state = State::kFailed;
+            continue;
+        }
+
+        if (!decoded.isPadded || !pack(decoded.image, entry.region))
+        {
+            auto data = std::make_shared<QOpenGLTexture>(decoded.image);
+            data->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+            data->setMagnificationFilter(QOpenGLTexture::Linear);
+
+            entry.region = {data};
+        }
+
+        entry.state = State::kReady;
+
+        // the mipmaps take the third of the base level
+        bytes += decoded.image.sizeInBytes() * 4 / 3;
+    }
+
+    // the atlas pages' mipmaps are rebuilt once for all images uploaded in the frame
+    for (auto& page : mAtlasPages)
+    {
+        if (page.isDirty)
+        {
+            page.data->generateMipMaps();
+            page.isDirty = false;
+        }
+    }
+
+    return isLeft || !mPendingLevels.empty();
+}
+
+void TextureManager::setReadyCallback(const ReadyCallback& callback)
+{
+    std::lock_guard<std::mutex> lock(mQueue->mutex);
+    mQueue->callback = callback;
+}
+
+void TextureManager::load(TextureID texture_id, const QString& filename, bool is_atlased)
+{
+    mLoadingCount++;
+    auto queue = mQueue;
+    QtConcurrent::run([queue, texture_id, filename, is_atlased, cacheDir = mCacheDir, isCompressed = mIsCompressed]() {
+        DecodedImage decoded{texture_id, {}, false, {}};
+        const auto& cacheFilename =
+            cacheDir.isEmpty() ? QString{} : TextureCache::cacheFilename(filename, isCompressed, cacheDir);
+        if (!cacheFilename.isEmpty())
+        {
+            // the compressed container isn't taken if the GPU can't sample it
+            decoded.cache = TextureCache::open(cacheFilename);
+            if (decoded.cache && decoded.cache->isCompressed() && !isCompressed)
+            {
+                decoded.cache.reset();
+            }
+        }
+
+        if (!decoded.cache)
+        {
+            // the image is converted to the texture's storage format here, so the upload doesn't convert it again
+            auto image = QImage(filename).mirrored().convertToFormat(QImage::Format_RGBA8888);
+            decoded.isPadded = is_atlased && !image.isNull() && image.width() <= kAtlasMaxImageSize &&
+                image.height() <= kAtlasMaxImageSize;
+
+            if (decoded.isPadded)
+            {
+                decoded.image = padImage(image);
+            }
+            else if (!cacheFilename.isEmpty() && TextureCache::write(cacheFilename, image, isCompressed))
+            {
+                decoded.cache = TextureCache::open(cacheFilename);
+            }
+
+            if (!decoded.isPadded && !decoded.cache)
+            {
+                decoded.image = image;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->images.push_back(decoded);
+        if (queue->callback)
+        {
+            queue->callback();
+        }
+    });
+}
+
+qint64 TextureManager::uploadLevel(TextureID texture_id)
+{
+    auto& entry      = mEntries[texture_id];
+    const auto level = entry.cache->getLevels()[static_cast<size_t>(entry.level)];
+    const auto& data = entry.region.data;
+    if (entry.cache->isCompressed())
+    {
+        data->setCompressedData(entry.level, level.size, level.data);
+    }
+    else
+    {
+        data->setData(entry.level, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, level.data);
+    }
+
+    // the texture is complete from the uploaded level to the coarsest one
+    data->setMipBaseLevel(entry.level);
+    entry.state = State::kReady;
+
+    if (entry.level-- == 0)
+    {
+        entry.cache.reset();
+        mPendingLevels.pop_front();
+    }
+
+    return level.size;
+}
+
+bool TextureManager::pack(const QImage& image, Region& region)
+{
+    QPoint position;
+    for (auto& page : mAtlasPages)
+    {
+        for (size_t layer{0}; layer < page.layers.size(); ++layer)
+        {
+            if (packShelf(page.layers[layer], kAtlasSize, image.size(), position))
+            {
+                page.data->bind();
+                QOpenGLContext::currentContext()->extraFunctions()->glTexSubImage3D(
+                    GL_TEXTURE_2D_ARRAY, 0, position.x(), position.y(), static_cast<GLint>(layer), image.width(),
+                    image.height(), 1, GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+                page.data->release();
+                page.isDirty = true;
+
+                const auto& scale  = 1.0f / kAtlasSize;
+                const auto& origin = position + QPoint{kAtlasPadding, kAtlasPadding};
+                const auto& size   = image.size() - QSize{kAtlasPadding * 2, kAtlasPadding * 2};
+                region.data        = page.data;
+                region.layer       = static_cast<int>(layer);
+                region.rect = {origin.x() * scale, origin.y() * scale, size.width() * scale, size.height() * scale};
+                return true;
+            }
+        }
+    }
+
+    // all pages are full, the new one is allocated
+    AtlasPage page;
+    page.data = std::make_shared<QOpenGLTexture>(QOpenGLTexture::Target2DArray);
+    page.data->setSize(kAtlasSize, kAtlasSize);
+    page.data->setLayers(kAtlasLayers);
+    page.data->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    page.data->setMipLevels(kAtlasMipLevels);
+    page.data->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+    page.data->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+    page.data->setMagnificationFilter(QOpenGLTexture::Linear);
+    page.data->setWrapMode(QOpenGLTexture::ClampToEdge);
+    page.layers.resize(kAtlasLayers);
+
+    if (!page.data->isStorageAllocated())
+    {
+        return false;
+    }
+
+    mAtlasPages.push_back(page);
+    return pack(image, region);
+}
+
+const TextureManager::Region& TextureManager::getPlaceholder()
+{
+    if (!mPlaceholder.data)
+    {
+        QImage image(1, 1, QImage::Format_RGBA8888);
+        image.fill(Qt::white);
+        mPlaceholder.data = std::make_shared<QOpenGLTexture>(image);
+    }
+
+    return mPlaceholder;
+}
@@ -1,7 +1,52 @@
 #include "gl_scene_utility.h"
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QDir>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GL_SCENE_SSE
+#include <xmmintrin.h>
+#endif
 
 using namespace gl_scene;
 
+namespace
+{
+
+const qint64 kHashBlockSize{1 << 30};
+const int kHashHexSize{32};
+
+QByteArray contentHash(const QString& source_filename)
+{
+    QFile source(source_filename);
+    if (!source.open(QIODevice::ReadOnly))
+    {
+        return {};
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    const uchar* data = source.map(0, source.size());
+    if (data != nullptr)
+    {
+        for (qint64 offset{0}; offset < source.size(); offset += kHashBlockSize)
+        {
+            const auto& size = std::min(kHashBlockSize, source.size() - offset);
+            hash.addData(reinterpret_cast<const char*>(data + offset), static_cast<int>(size));
+        }
+    }
+    else if (!hash.addData(&source))
+    {
+        return {};
+    }
+
+    return hash.result().toHex();
+}
+
+}  // namespace
+
 Vec3 gl_scene::toVec3(const Color& color)
 {
     return {static_cast<float>(color.redF()), static_cast<float>(color.greenF()), static_cast<float>(color.blueF())};
@@ -103,3 +148,160 @@ Point3 gl_scene::toPoint3(const Vec3& vec)
 {
     return {vec.x(), vec.y(), vec.z()};
 }
+
+QString gl_scene::cacheFilename(const QString& source_filename, const QString& cache_dir, const QString& suffix)
+{
+    QFileInfo info(source_filename);
+    if (!info.isFile())
+    {
+        return {};
+    }
+
+    QDir dir(cache_dir.isEmpty() ? info.absolutePath() : cache_dir);
+
+    QCryptographicHash stamp(QCryptographicHash::Md5);
+    stamp.addData(info.absoluteFilePath().toUtf8());
+    stamp.addData(QByteArray::number(info.size()));
+    stamp.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    const auto& stampFilename =
+        dir.filePath(info.completeBaseName() + "." + QString::fromLatin1(stamp.result().toHex()) + ".stamp");
+
+    QByteArray hash;
+    QFile stampFile(stampFilename);
+    if (stampFile.open(QIODevice::ReadOnly))
+    {
+        hash = stampFile.read(kHashHexSize);
+    }
+
+    if (hash.size() != kHashHexSize)
+    {
+        hash = contentHash(source_filename);
+        if (hash.isEmpty())
+        {
+            return {};
+        }
+
+        QSaveFile file(stampFilename);
+        if (file.open(QIODevice::WriteOnly) && file.write(hash) == hash.size())
+        {
+            file.commit();
+        }
+    }
+
+    return dir.filePath(info.completeBaseName() + "." + QString::fromLatin1(hash) + "." + suffix);
+}
+
+bool gl_scene::packShelf(Shelves& shelves, int area_size, const QSize& size, QPoint& position)
+{
+    for (auto& shelf : shelves)
+    {
+        if (size.height() <= shelf.height && shelf.x + size.width() <= area_size)
+        {
+            position = {shelf.x, shelf.y};
+            shelf.x += size.width();
+            return true;
+        }
+    }
+
+    const auto& top = shelves.empty() ? 0 : shelves.back().y + shelves.back().height;
+    if (top + size.height() > area_size || size.width() > area_size)
+    {
+        return false;
+    }
+
+    shelves.push_back({size.width(), top, size.height()});
+    position = {0, top};
+    return true;
+}
+
+void gl_scene::transformPoints(const Mat4& transformation, const float* points, size_t count, float* result)
+{
+    // the matrix is column-major
+    const auto* m = transformation.constData();
+    size_t index{0};
+
+#ifdef GL_SCENE_SSE
+    // four points are transformed at once, their coordinates are regrouped into the lanes
+    for (; index + 4 <= count; index += 4)
+    {
+        const auto* p = points + index * 3;
+        const auto& x = _mm_setr_ps(p[0], p[3], p[6], p[9]);
+        const auto& y = _mm_setr_ps(p[1], p[4], p[7], p[10]);
+        const auto& z = _mm_setr_ps(p[2], p[5], p[8], p[11]);
+
+        __m128 clip[4];
+        for (size_t row{0}; row < 4; ++row)
+        {
+            const auto& xy = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m[row])), _mm_mul_ps(y, _mm_set1_ps(m[4 + row])));
+            const auto& zw = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m[8 + row])), _mm_set1_ps(m[12 + row]));
+            clip[row]      = _mm_add_ps(xy, zw);
+        }
+
+        // the zero w is replaced by one as QVector3D::unproject does
+        const auto& isZero = _mm_cmpeq_ps(clip[3], _mm_setzero_ps());
+        const auto& w      = _mm_or_ps(_mm_and_ps(isZero, _mm_set1_ps(1.0f)), _mm_andnot_ps(isZero, clip[3]));
+
+        alignas(16) float lanes[3][4];
+        _mm_store_ps(lanes[0], _mm_div_ps(clip[0], w));
+        _mm_store_ps(lanes[1], _mm_div_ps(clip[1], w));
+        _mm_store_ps(lanes[2], _mm_div_ps(clip[2], w));
+
+        auto* r = result + index * 3;
+        for (size_t lane{0}; lane < 4; ++lane)
+        {
+            r[lane * 3]     = lanes[0][lane];
+            r[lane * 3 + 1] = lanes[1][lane];
+            r[lane * 3 + 2] = lanes[2][lane];
+        }
+    }
+#endif
+
+    for (; index < count; ++index)
+    {
+        const auto* p = points + index * 3;
+        const auto x  = p[0];
+        const auto y  = p[1];
+        const auto z  = p[2];
+        auto w        = m[3] * x + m[7] * y + m[11] * z + m[15];
+        w             = w == 0.0f ? 1.0f : w;
+
+        auto* r = result + index * 3;
+        r[0]    = (m[0] * x + m[4] * y + m[8] * z + m[12]) / w;
+        r[1]    = (m[1] * x + m[5] * y + m[9] * z + m[13]) / w;
+        r[2]    = (m[2] * x + m[6] * y + m[10] * z + m[14]) / w;
+    }
+}
+
+void gl_scene::calculateBounds(const Vertex* vertices, size_t count, Vec3& min, Vec3& max)
+{
+    min = max = count > 0 ? Vec3{vertices[0][0], vertices[0][1], vertices[0][2]} : Vec3{};
+    for (size_t index{1}; index < count; ++index)
+    {
+        const auto& vertex = vertices[index];
+        for (int axis{0}; axis < 3; ++axis)
+        {
+            min[axis] = std::min(min[axis], vertex[static_cast<size_t>(axis)]);
+            max[axis] = std::max(max[axis], vertex[static_cast<size_t>(axis)]);
+        }
+    }
+}
+
+void gl_scene::transformBounds(const Mat4& transformation, Vec3& min, Vec3& max)
+{
+    // the center is transformed as the point, the half extent by the absolute values of the matrix
+    const auto* m      = transformation.constData();
+    const auto& center = (min + max) * 0.5f;
+    const auto& extent = (max - min) * 0.5f;
+
+    Vec3 worldCenter;
+    Vec3 worldExtent;
+    for (int row{0}; row < 3; ++row)
+    {
+        worldCenter[row] = m[row] * center.x() + m[4 + row] * center.y() + m[8 + row] * center.z() + m[12 + row];
+        worldExtent[row] = std::abs(m[row]) * extent.x() + std::abs(m[4 + row]) * extent.y() +
+                           std::abs(m[8 + row]) * extent.z();
+    }
+
+    min = worldCenter - worldExtent;
+    max = worldCenter + worldExtent;
+}
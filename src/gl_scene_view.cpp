@@ -1,43 +1,113 @@
 #include "gl_scene_view.h"
+#include "gl_scene_utility.h"
 #include <QOpenGLFramebufferObject>
 #include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLTimerQuery>
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include <QKeyEvent>
 #include <QGLFormat>
+#include <QDebug>
 #include <QtMath>
+#include <algorithm>
 #include <chrono>
 #include <deque>
+#include <tuple>
 
 //#define SHOW_DEBUG
 
 using namespace gl_scene;
 
+namespace
+{
+
+// the average number of the shifts per item the insertion sort could take before the full sort replaces it
+const size_t kMaxTransparentShifts{8};
+
+// the frame isn't swapped by then, so the scheduler doesn't wait for it anymore (in milliseconds)
+const int kSwapTimeout{100};
+
+}  // namespace
+
 GLSceneView::GLSceneView(QWidget* parent) : QOpenGLWidget(parent)
 {
     QSurfaceFormat format;
     format.setProfile(QSurfaceFormat::CoreProfile);
-    format.setSamples(16);
     setFormat(format);
 
     mManipulator = std::make_shared<StandartManipulator>(mCamera);
-    mGlassWidget = new GLSceneGlass(this);
-    mGlassWidget->setAttribute(Qt::WA_TransparentForMouseEvents);
     setMouseTracking(true);
     makeCurrent();
 
     connect(&mCamera, &Camera::signalChanged, [&](const Mat4& transformation) {
-        mGlassWidget->setTransformation(transformation);
         emit signalCameraChanged(transformation);
-        update();
+        mFrameScheduler.invalidate(FrameScheduler::kCamera);
+    });
+    connect(this, &QOpenGLWidget::frameSwapped, [this]() {
+        mSwapTimer.stop();
+        mFrameScheduler.endFrame();
     });
+
+    // not every paint is followed by the swap, the next frames would never be requested then
+    mSwapTimer.setSingleShot(true);
+    mSwapTimer.setInterval(kSwapTimeout);
+    connect(&mSwapTimer, &QTimer::timeout, [this]() { mFrameScheduler.endFrame(); });
 }
 
 GLSceneView::~GLSceneView()
 {
+    if (mScene)
+    {
+        mScene->removeChangedListener(mSceneListenerId);
+    }
+
+    // the textures could outlive the view, their producers mustn't call it back
+    for (const auto& texture : mStreamingTextures)
+    {
+        texture->setReadyCallback(nullptr);
+    }
+
     cleanup();
 }
 
+void GLSceneView::invalidate()
+{
+    mFrameScheduler.invalidate(FrameScheduler::kScene);
+}
+
+void GLSceneView::startAnimation()
+{
+    mFrameScheduler.startAnimation();
+}
+
+void GLSceneView::stopAnimation()
+{
+    mFrameScheduler.stopAnimation();
+}
+
+size_t GLSceneView::addViewport(const QRectF& area, const Camera::Ptr& camera)
+{
+    connect(camera.get(), &Camera::signalChanged, this,
+            [this]() { mFrameScheduler.invalidate(FrameScheduler::kCamera); });
+    mViewports.push_back({area, camera});
+    resizeViewports();
+    mFrameScheduler.invalidate(FrameScheduler::kCamera);
+
+    return mViewports.size() - 1;
+}
+
+void GLSceneView::removeViewport(size_t index)
+{
+    if (index < mViewports.size())
+    {
+        disconnect(mViewports[index].camera.get(), nullptr, this, nullptr);
+        mTransparentOrders.erase(mViewports[index].camera.get());
+        mViewports.erase(mViewports.begin() + static_cast<std::ptrdiff_t>(index));
+        mFrameScheduler.invalidate(FrameScheduler::kCamera);
+    }
+}
+
 void GLSceneView::focusCamera(const Vec3& point)
 {
     if (!std::isnan(point.x()) && !std::isnan(point.y()) && !std::isnan(point.z()))
@@ -51,6 +121,12 @@ void GLSceneView::zoomCamera(int delta)
     mManipulator->zoom(delta, mCamera);
 }
 
+void GLSceneView::addStreamingTexture(const StreamingTexture::Ptr& texture)
+{
+    texture->setReadyCallback([this]() { scheduleUpdate(); });
+    mStreamingTextures.push_back(texture);
+}
+
 void GLSceneView::setRectZoomMode(bool mode)
 {
     mManipulator->setRectZoomMode(mode);
@@ -65,26 +141,146 @@ void GLSceneView::setManipulator(Manipulator::Ptr manipulator)
 {
     mManipulator = manipulator;
     mManipulator->reset(mCamera);
-    update();
+    mFrameScheduler.invalidate(FrameScheduler::kCamera);
+}
+
+void GLSceneView::setScene(Scene::Ptr scene)
+{
+    if (mScene)
+    {
+        mScene->removeChangedListener(mSceneListenerId);
+    }
+
+    mScene           = scene;
+    mSceneListenerId = mScene->addChangedListener([this]() { mFrameScheduler.invalidate(FrameScheduler::kScene); });
+    mFrameScheduler.invalidate(FrameScheduler::kScene);
+}
+
+void GLSceneView::setBackgroundColor(const Color& color)
+{
+    mBackgroundColor = color;
+    mFrameScheduler.invalidate(FrameScheduler::kScene);
+}
+
+void GLSceneView::setSelectedItemIds(const Item::IdPack& ids)
+{
+    mSelectedItemIds = ids;
+    mFrameScheduler.invalidate(FrameScheduler::kSelection);
+}
+
+void GLSceneView::setTextVisibile(bool is_visible)
+{
+    mIsTextVisible = is_visible;
+    mFrameScheduler.invalidate(FrameScheduler::kOverlay);
+}
+
+void GLSceneView::setOcclusionCulling(bool is_enabled)
+{
+    // the depth captured before the switch could be outdated
+    mIsOcclusionCulling = is_enabled;
+    mOcclusionCuller.reset();
+    mFrameScheduler.invalidate(FrameScheduler::kScene);
+}
+
+void GLSceneView::setProgramCache(const QString& cache_dir)
+{
+    mProgramCacheDir = cache_dir;
+}
+
+void GLSceneView::setMainViewport(const QRectF& area)
+{
+    mMainViewportArea = area;
+    resizeViewports();
+    mFrameScheduler.invalidate(FrameScheduler::kCamera);
+}
+
+void GLSceneView::setTextureCache(const QString& cache_dir, bool is_compressed)
+{
+    mTextureCacheDir     = cache_dir;
+    mIsTextureCompressed = is_compressed;
 }
 
 void GLSceneView::initializeGL()
 {
     initializeOpenGLFunctions();
+    mCapabilities = Capabilities::detect();
+
+    // the view stays blank on the older contexts, their shaders aren't compiled
+    if (!mCapabilities.isSupported())
+    {
+        qCritical() << "GLSceneView: the OpenGL 3.0 context is required at least, the context is"
+                    << mCapabilities.toString();
+        return;
+    }
+
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     mStandartRenderAttributes = {1.0f, {GL_DEPTH_TEST, GL_CULL_FACE, GL_LINE_SMOOTH}, {GL_BLEND}};
     mPickingRenderAttributes  = {1.0f, {GL_DEPTH_TEST, GL_CULL_FACE}, {GL_LINE_SMOOTH, GL_BLEND}};
+    mTextRenderAttributes     = {1.0f, {GL_BLEND}, {GL_DEPTH_TEST, GL_CULL_FACE}};
+
+    // the blended items are tested against the depth of the others, but don't write it
+    mTransparentRenderAttributes = {1.0f, {GL_DEPTH_TEST, GL_CULL_FACE, GL_LINE_SMOOTH, GL_BLEND}, {}};
     setRenderAttributes(mStandartRenderAttributes);
 
-    const auto& vertices = mScene->getVertices();
-    const auto& size     = static_cast<int>(vertices.size() * sizeof(Vertex));
-    Pipe::Attributes attributes{{3, 8, 0}, {3, 8, 3}, {2, 8, 6}};
+    // the programs, the static geometry and the textures are shared by the views of the share group
+    const auto& isCompressed = mIsTextureCompressed && context()->hasExtension("GL_EXT_texture_compression_s3tc");
+    mResourceManager         = ResourceManager::acquire(mScene, mTextureCacheDir, isCompressed, mProgramCacheDir);
+    mResourceManager->addReadyCallback(this, [this]() { scheduleUpdate(); });
+    mTextureManager = mResourceManager->getTextureManager();
+
+    const auto& attributes = defaults::pipes::kAttributes;
+    auto isIndirectLinked  = true;
     for (auto& shaderPair : mScene->getShaders())
     {
+        // the dynamic pipe shares the program only, the mutable geometry is streamed into its own buffer
         PipeID pipeId         = shaderPair.first;
-        Shader shader         = shaderPair.second;
-        mStaticPipes[pipeId]  = std::make_shared<PipeExt>(shader, vertices.data(), size, attributes);
-        mDynamicPipes[pipeId] = std::make_shared<PipeExt>(shader, vertices.data(), size, attributes);
+        const auto& resources = mResourceManager->getResources(pipeId);
+        mStaticPipes[pipeId]  = std::make_shared<PipeExt>(resources, attributes);
+        mDynamicPipes[pipeId] = std::make_shared<PipeExt>(Pipe::Resources{resources.program}, attributes);
+
+        for (auto& pipe : {mStaticPipes[pipeId], mDynamicPipes[pipeId]})
+        {
+            pipe->bind();
+            pipe->setTextureUnits(0, defaults::textures::kAtlasUnit);
+            pipe->setAtlasRegion(-1, {0.0f, 0.0f, 1.0f, 1.0f});
+            pipe->setAlfa(1.0f);
+            pipe->release();
+        }
+
+        // the indirect pipe draws the static geometry with the per item data taken from its own buffer
+        const auto& indirectResources = mResourceManager->getIndirectResources(pipeId);
+        isIndirectLinked              = isIndirectLinked && indirectResources.program != nullptr;
+        if (mCapabilities.isMultiDrawIndirect && indirectResources.program && pipeId != defaults::pipes::id::kSelection)
+        {
+            const auto& selectionProgram =
+                mResourceManager->getIndirectResources(defaults::pipes::id::kSelection).program;
+            const auto& indirectPipe = std::make_shared<IndirectPipe>(indirectResources, attributes, selectionProgram);
+            indirectPipe->bind();
+            indirectPipe->setTextureUnits(0, defaults::textures::kAtlasUnit);
+            indirectPipe->release();
+            mIndirectPipes[pipeId] = indirectPipe;
+        }
+    }
+
+    // the paths actually taken are reported by the capabilities (see getCapabilities)
+    Capabilities::RenderPaths paths;
+    paths.isIndirect       = !mIndirectPipes.empty();
+    paths.isGpuCulling     = paths.isIndirect && mResourceManager->getCullingProgram() != nullptr;
+    paths.isBaseVertex     = mCapabilities.isBaseVertex;
+    paths.isIndirectLinked = isIndirectLinked;
+    mCapabilities.choosePaths(paths);
+
+    mTextRenderer    = std::make_shared<TextRenderer>();
+    mOverlayRenderer = std::make_shared<OverlayRenderer>();
+
+    // the frame time is measured on the GPU, where the multisampling and the resolution cost
+    for (auto& timer : mFrameTimers)
+    {
+        timer.query = mCapabilities.isTimerQuery ? std::make_shared<QOpenGLTimerQuery>() : nullptr;
+        if (timer.query && !timer.query->create())
+        {
+            timer.query.reset();
+        }
     }
 
     connect(context(), &QOpenGLContext::aboutToBeDestroyed, this, &GLSceneView::cleanup);
@@ -92,6 +288,11 @@ void GLSceneView::initializeGL()
 
 void GLSceneView::pickItems(int x1, int y1, int x2, int y2, int mask, bool is_selection)
 {
+    if (!mResourceManager)
+    {
+        return;
+    }
+
     makeCurrent();
 
     QOpenGLFramebufferObjectFormat selectionBufferFormat;
@@ -107,7 +308,10 @@ void GLSceneView::pickItems(int x1, int y1, int x2, int y2, int mask, bool is_se
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     setRenderAttributes(mPickingRenderAttributes);
-    paintItems(false);
+    const auto& viewport = toPixels(mMainViewportArea, size());
+    glViewport(viewport.x(), viewport.y(), viewport.width(), viewport.height());
+    buildDrawList(false);
+    paintItems(mCamera, false);
 
     mSelectionBuffer.release();
 
@@ -146,6 +350,7 @@ void GLSceneView::pickItems(int x1, int y1, int x2, int y2, int mask, bool is_se
     if (mHoveredItemId != hoveredItemId)
     {
         mHoveredItemId = hoveredItemId;
+        mFrameScheduler.invalidate(FrameScheduler::kSelection);
         if (mHoveredItemId != 0)
         {
             emit signalHoverChanged(true, mHoveredItemId);
@@ -158,6 +363,7 @@ void GLSceneView::pickItems(int x1, int y1, int x2, int y2, int mask, bool is_se
     // image.save(QString("fb1.bmp"), 0, 0);
     if (is_selection)
     {
+        mFrameScheduler.invalidate(FrameScheduler::kSelection);
         emit signalSelectionChanged(mSelectedItemIds);
     }
 }
@@ -165,8 +371,7 @@ void GLSceneView::pickItems(int x1, int y1, int x2, int y2, int mask, bool is_se
 void GLSceneView::resizeGL(int w, int h)
 {
     glViewport(0, 0, w, h);
-    mCamera.setViewPort(w, h);
-    mGlassWidget->setGeometry(0, 0, w, h);
+    resizeViewports();
 }
 
 void GLSceneView::paintGL()
@@ -176,13 +381,95 @@ void GLSceneView::paintGL()
     auto t1 = system_clock::now().time_since_epoch();
 #endif
 
+    // the frame could be forced by the window system (e.g. exposing), so it's rendered regardless of the reasons
+    const auto& reasons = mFrameScheduler.beginFrame();
+    if (!mResourceManager)
+    {
+        mSwapTimer.start();
+        return;
+    }
+
+    // the quality is refined frame by frame after the interaction, so the frames go on until it's full
+    const auto& quality = mQualityController.beginFrame(mManipulator->isDragMode());
+    if (mQualityController.isRefining())
+    {
+        mFrameScheduler.invalidate(FrameScheduler::kAnimation);
+    }
+
+    if (mTextureManager->upload(mUploadBudget))
+    {
+        mFrameScheduler.invalidate(FrameScheduler::kResources);
+    }
+
+    for (const auto& texture : mStreamingTextures)
+    {
+        texture->upload();
+    }
+
+    // the depth pyramid of one of the previous frames is taken once the GPU has read it back
+    if (mIsOcclusionCulling)
+    {
+        mOcclusionCuller.update();
+    }
+
+    bindSceneBuffer(quality);
+    beginFrameTimer();
+
     glClearColor(static_cast<float>(mBackgroundColor.redF()), static_cast<float>(mBackgroundColor.greenF()),
                  static_cast<float>(mBackgroundColor.blueF()), static_cast<float>(mBackgroundColor.alphaF()));
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    paintItems();
-    paintTextItems();
+    // the items are traversed and the mutable geometry is uploaded once, the viewports differ by the culling only
+    buildDrawList();
+
+    const auto& bufferSize   = mSceneBuffer->size();
+    const auto& mainViewport = toPixels(mMainViewportArea, bufferSize);
+    glViewport(mainViewport.x(), mainViewport.y(), mainViewport.width(), mainViewport.height());
+    paintItems(mCamera);
+
+    for (const auto& viewport : mViewports)
+    {
+        const auto& rect = toPixels(viewport.area, bufferSize);
+        glViewport(rect.x(), rect.y(), rect.width(), rect.height());
+        glScissor(rect.x(), rect.y(), rect.width(), rect.height());
+        glEnable(GL_SCISSOR_TEST);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+        paintItems(*viewport.camera);
+    }
+
+    // the frames requested by the readbacks only change nothing, so their depth isn't read back again
+    const auto& isChanged = reasons == 0 || (reasons & ~(FrameScheduler::kOcclusion | FrameScheduler::kDepthMap)) != 0;
+    mIsDepthMapStale      = mIsDepthMapStale || isChanged;
+
+    // the main viewport's depth is read back for the next frames' occlusion culling, the frames go on until the
+    // depth of the latest change is captured and taken, otherwise the pyramid would stay stale
+    if (mIsOcclusionCulling)
+    {
+        mIsOcclusionStale = mIsOcclusionStale || isChanged;
+        if (mIsOcclusionStale && !mOcclusionCuller.isCapturing())
+        {
+            mOcclusionCuller.capture(mSceneBuffer->handle(), bufferSize, mainViewport, mCamera.getState());
+            mSceneBuffer->bind();
+            mIsOcclusionStale = false;
+        }
+
+        if (mIsOcclusionStale || mOcclusionCuller.isCapturing())
+        {
+            mFrameScheduler.invalidate(FrameScheduler::kOcclusion);
+        }
+    }
+
+    endFrameTimer();
+    resolveSceneBuffer();
+
+    if (quality.isTextVisible)
+    {
+        paintTextItems();
+    }
+    paintOverlay();
+    mSwapTimer.start();
 
 #ifdef SHOW_DEBUG
     auto t2 = system_clock::now().time_since_epoch();
@@ -190,146 +477,826 @@ void GLSceneView::paintGL()
 #endif
 }
 
-void GLSceneView::paintItems(bool is_standart_drawing)
+void GLSceneView::bindSceneBuffer(const QualityLevel& quality)
 {
-    PipeExt::Ptr curPipe;
-    Texture::Ptr curTexture;
-    auto light(mScene->getLight());
-    light.direction = mCamera.getFront();
+    // the scaled buffer is stretched by the blit, which isn't allowed for the multisampled one
+    const auto& bufferSize = size() * devicePixelRatioF() * quality.scale;
+    const auto& samples    = bufferSize == size() * devicePixelRatioF() ? quality.samples : 0;
+    if (!mSceneBuffer || mSceneBuffer->size() != bufferSize || mSceneBufferSamples != samples)
+    {
+        QOpenGLFramebufferObjectFormat sceneBufferFormat;
+        sceneBufferFormat.setSamples(samples);
+        sceneBufferFormat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+
+        mSceneBuffer        = std::make_shared<QOpenGLFramebufferObject>(bufferSize, sceneBufferFormat);
+        mSceneBufferSamples = samples;
+    }
+
+    mSceneBuffer->bind();
+    glViewport(0, 0, bufferSize.width(), bufferSize.height());
+}
+
+void GLSceneView::resolveSceneBuffer()
+{
+    const auto& sourceSize = mSceneBuffer->size();
+    const auto& targetSize = size() * devicePixelRatioF();
+    const auto& isScaled   = sourceSize != targetSize;
+
+    auto* functions = context()->extraFunctions();
+    functions->glBindFramebuffer(GL_READ_FRAMEBUFFER, mSceneBuffer->handle());
+    functions->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, defaultFramebufferObject());
+    functions->glBlitFramebuffer(0, 0, sourceSize.width(), sourceSize.height(), 0, 0, targetSize.width(),
+                                 targetSize.height(), GL_COLOR_BUFFER_BIT, isScaled ? GL_LINEAR : GL_NEAREST);
+    functions->glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    glViewport(0, 0, targetSize.width(), targetSize.height());
+}
+
+void GLSceneView::beginFrameTimer()
+{
+    auto& timer = mFrameTimers[mFrameTimerIndex];
+    if (!timer.query)
+    {
+        return;
+    }
+
+    // the query of two frames ago is read, so the result is available without waiting for the GPU
+    if (timer.isStarted && timer.query->isResultAvailable())
+    {
+        mQualityController.addFrameTime(static_cast<float>(timer.query->waitForResult()) / 1e6f);
+    }
+
+    timer.query->begin();
+    timer.isStarted = true;
+}
+
+void GLSceneView::endFrameTimer()
+{
+    auto& timer = mFrameTimers[mFrameTimerIndex];
+    if (timer.query)
+    {
+        timer.query->end();
+    }
+
+    mFrameTimerIndex = (mFrameTimerIndex + 1) % mFrameTimers.size();
+}
+
+void GLSceneView::buildDrawList(bool is_standart_drawing)
+{
+    // the mutable items of each pipe are streamed into its buffer with a single allocation
+    std::map<PipeExt*, std::pair<BufferSegments, GLint>> dynamicSegments;
+    mDrawList.clear();
+    mHiddenSlots.clear();
+    updateBatches();
 
     for (const auto& itemsPair : mScene->getItems())
     {
         const auto& pipeId = is_standart_drawing ? itemsPair.first : defaults::pipes::id::kSelection;
         const auto& items  = itemsPair.second;
 
-        auto& staticPipe  = mStaticPipes[pipeId];
-        auto& dynamicPipe = mDynamicPipes[pipeId];
+        auto* staticPipe  = mStaticPipes[pipeId].get();
+        auto* dynamicPipe = mDynamicPipes[pipeId].get();
 
-        for (auto& item : items)
+        // the static items are drawn by the indirect commands where the multi-draw indirect is available (the
+        // selection pass draws them by the same pipe with the selection program)
+        const auto& indirectPair = mIndirectPipes.find(itemsPair.first);
+        auto* indirectPipe       = indirectPair != mIndirectPipes.end() ? indirectPair->second.get() : nullptr;
+
+        for (size_t index{0}; index < items.size(); ++index)
         {
-            if (item->isVisible)
+            const auto& item = items[index];
+            if (!item->isVisible || (!is_standart_drawing && item->id == 0))
+            {
+                continue;
+            }
+
+            // the frozen items are drawn by their batches, the highlighted ones are drawn by their own calls instead,
+            // as well as the ones of the batches without the pipe (their program isn't linked)
+            const auto* frozenLocation = mScene->findFrozen(*item);
+            if (frozenLocation != nullptr && frozenLocation->batch < mBatchPipes.size() &&
+                mBatchPipes[frozenLocation->batch])
             {
-                // define pipe
-                auto& pipe = item->isMutableGeometry ? dynamicPipe : staticPipe;
-                if (curPipe != pipe)
+                if (!is_standart_drawing || !isHighlighted(*item))
                 {
-                    if (curPipe)
-                    {
-                        curPipe->release();
-                    }
-                    pipe->bind();
-                    pipe->setLight(light);
-                    pipe->setView(mCamera.getPosition(), mCamera.getProjection(), mCamera.getView());
-                    curPipe = pipe;
+                    continue;
                 }
 
-                // define texture
-                auto texture = item->texture ? item->texture : mScene->getTexture(item->textureId);
-                if (texture && curTexture != texture)
+                mHiddenSlots.push_back(*frozenLocation);
+            }
+
+            DrawItem drawItem{item.get(), staticPipe, {}, nullptr, 0, nullptr};
+            if (item->isMutableGeometry)
+            {
+                auto& segments    = dynamicSegments[dynamicPipe];
+                const auto& count = static_cast<GLsizei>(item->vertexPack.size());
+                drawItem.pipe     = dynamicPipe;
+                drawItem.geometry = {segments.second, count};
+                calculateBounds(item->vertexPack.data(), item->vertexPack.size(), drawItem.geometry.min,
+                                drawItem.geometry.max);
+
+                segments.first.push_back({item->vertexPack.data(), count * static_cast<int>(sizeof(Vertex))});
+                segments.second += count;
+            }
+            else
+            {
+                drawItem.geometry = mScene->getGeometryData(item->meshId);
+            }
+
+            // the bounds of the draw item are kept in the world coordinates
+            transformBounds(item->transformation, drawItem.geometry.min, drawItem.geometry.max);
+
+            if (indirectPipe && !item->isMutableGeometry && !item->texture)
+            {
+                const auto& region  = mTextureManager->get(item->textureId);
+                const auto& color   = getItemColor(*item, true);
+                const auto& idColor = getItemColor(*item, false);
+                const auto& normal  = item->transformation.normalMatrix();
+                const auto& bounds  = drawItem.geometry;
+
+                IndirectPipe::ItemData itemData;
+                std::copy(item->transformation.constData(), item->transformation.constData() + 16,
+                          itemData.model.begin());
+                std::copy(normal.constData(), normal.constData() + 9, itemData.normal.begin());
+                itemData.color      = {static_cast<float>(color.redF()), static_cast<float>(color.greenF()),
+                                  static_cast<float>(color.blueF()), item->renderParameters.alfa};
+                itemData.atlasRect  = {region.rect.x(), region.rect.y(), region.rect.z(), region.rect.w()};
+                itemData.atlasLayer = static_cast<float>(region.layer);
+                itemData.idColor    = {static_cast<float>(idColor.redF()), static_cast<float>(idColor.greenF()),
+                                    static_cast<float>(idColor.blueF()), 1.0f};
+                itemData.boundsMin  = {bounds.min.x(), bounds.min.y(), bounds.min.z()};
+                itemData.boundsMax  = {bounds.max.x(), bounds.max.y(), bounds.max.z()};
+
+                // the scene's items are only appended, so the item's position is its stable record in the table
+                drawItem.indirectPipe  = indirectPipe;
+                drawItem.indirectIndex = static_cast<GLuint>(index);
+                drawItem.region        = &region;
+                indirectPipe->setItem(drawItem.indirectIndex, itemData);
+            }
+
+            mDrawList.push_back(drawItem);
+        }
+    }
+
+    for (const auto& segmentsPair : dynamicSegments)
+    {
+        auto* pipe = segmentsPair.first;
+        pipe->bind();
+        pipe->allocate(segmentsPair.second.first);
+        pipe->release();
+    }
+
+    // only the changed records reach the GPU
+    for (const auto& indirectPair : mIndirectPipes)
+    {
+        auto* pipe = indirectPair.second.get();
+        pipe->bind();
+        pipe->uploadItems();
+        pipe->release();
+    }
+
+    // the batches skip the hidden slots in their order
+    std::sort(mHiddenSlots.begin(), mHiddenSlots.end(), [](const auto& first, const auto& second) {
+        return std::tie(first.batch, first.slot) < std::tie(second.batch, second.slot);
+    });
+}
+
+void GLSceneView::updateBatches()
+{
+    // the pipes are created for the batches built since the previous frame, the built ones take the thaws only
+    const auto& batches          = mScene->getBatches();
+    const auto& selectionProgram = mResourceManager->getIndirectResources(defaults::pipes::id::kSelection).program;
+    for (size_t index{0}; index < batches.size(); ++index)
+    {
+        const auto& batch = batches[index];
+        if (index == mBatchPipes.size())
+        {
+            const auto& program = mResourceManager->getIndirectResources(batch.pipeId).program;
+            mBatchPipes.push_back(program ? std::make_shared<BatchPipe>(program, selectionProgram) : nullptr);
+            if (mBatchPipes.back())
+            {
+                mBatchPipes.back()->bind();
+                mBatchPipes.back()->setTextureUnits(0, defaults::textures::kAtlasUnit);
+                mBatchPipes.back()->release();
+            }
+        }
+
+        if (mBatchPipes[index])
+        {
+            mBatchPipes[index]->upload(batch);
+        }
+    }
+}
+
+void GLSceneView::paintItems(const Camera& camera, bool is_standart_drawing)
+{
+    PipeExt* curPipe{nullptr};
+    Texture::Ptr curTexture;
+    Texture::Ptr curAtlas;
+    TextureID curTextureId{0};
+    const TextureManager::Region* region{nullptr};
+    TextureManager::Region itemRegion;
+    int curLayer{-1};
+    QVector4D curRect;
+    auto light(mScene->getLight());
+    light.direction   = camera.getFront();
+    const auto& state = camera.getState();
+
+    // the indirect items are culled by the compute pass if it's enabled, all of them go to the commands then
+    const auto& cullingProgram = mResourceManager->getCullingProgram();
+    const auto& isGpuCulling   = mIsGpuCulling && cullingProgram;
+
+    // the occlusion is tested for the main viewport only, its depth is the one captured
+    const auto& isOcclusionCulling = mIsOcclusionCulling && is_standart_drawing && &camera == &mCamera;
+    mItemUniforms                  = {};
+    mVisibleItems.clear();
+    mTransparentItems.clear();
+    for (const auto& drawItem : mDrawList)
+    {
+        const auto& min           = drawItem.geometry.min;
+        const auto& max           = drawItem.geometry.max;
+        const auto& isTransparent = is_standart_drawing && drawItem.item->renderParameters.alfa < 1.0f;
+        if (isGpuCulling && drawItem.indirectPipe && !isTransparent)
+        {
+            mVisibleItems.push_back(&drawItem);
+        }
+        else if (state.isVisible(min, max) && !(isOcclusionCulling && mOcclusionCuller.isOccluded(min, max)))
+        {
+            if (isTransparent)
+            {
+                mTransparentItems.push_back({&drawItem, 0.0f});
+            }
+            else
+            {
+                mVisibleItems.push_back(&drawItem);
+            }
+        }
+    }
+
+    // the blended items are drawn after the others from the farthest one
+    mTransparentBegin = mVisibleItems.size();
+    sortTransparentItems(camera);
+
+    for (const auto& indirectPair : mIndirectPipes)
+    {
+        indirectPair.second->setGpuCulling(isGpuCulling);
+        indirectPair.second->setSelection(!is_standart_drawing);
+    }
+
+    prepareIndirectRuns();
+    if (isGpuCulling)
+    {
+        for (const auto& indirectPair : mIndirectPipes)
+        {
+            indirectPair.second->cull(*cullingProgram, state.frustum);
+        }
+    }
+
+    // the batches are opaque, they go before the items
+    paintBatches(camera, light, is_standart_drawing, isOcclusionCulling);
+
+    auto run = mIndirectRuns.cbegin();
+
+    for (size_t index{0}; index < mVisibleItems.size(); ++index)
+    {
+        const auto& drawItem   = *mVisibleItems[index];
+        const auto& isIndirect = run != mIndirectRuns.cend() && run->begin == index;
+        if (index == mTransparentBegin)
+        {
+            setRenderAttributes(mTransparentRenderAttributes);
+            glDepthMask(GL_FALSE);
+        }
+
+        // define pipe
+        auto* pipe       = isIndirect ? drawItem.indirectPipe : drawItem.pipe;
+        const auto& item = drawItem.item;
+        if (curPipe != pipe)
+        {
+            if (curPipe)
+            {
+                curPipe->release();
+            }
+            pipe->bind();
+            pipe->setLight(light);
+            pipe->setView(camera.getPosition(), camera.getProjection(), camera.getView());
+            pipe->setAtlasRegion(curLayer, curRect);
+            curPipe = pipe;
+        }
+
+        // define texture (it is resolved once for the run of items with the same texture ID)
+        if (drawItem.region)
+        {
+            region       = drawItem.region;
+            curTextureId = item->textureId;
+        }
+        else if (item->texture)
+        {
+            itemRegion = {item->texture};
+            region     = &itemRegion;
+        }
+        else if (region == nullptr || region == &itemRegion || curTextureId != item->textureId)
+        {
+            region       = &mTextureManager->get(item->textureId);
+            curTextureId = item->textureId;
+        }
+
+        const auto& texture = region->data;
+        if (texture)
+        {
+            if (region->layer < 0 && curTexture != texture)
+            {
+                if (curTexture)
                 {
-                    if (curTexture)
-                    {
-                        curTexture->release();
-                    }
-                    texture->bind();
-                    curTexture = texture;
+                    curTexture->release();
                 }
+                texture->bind();
+                curTexture = texture;
+            }
+            else if (region->layer >= 0 && curAtlas != texture)
+            {
+                texture->bind(defaults::textures::kAtlasUnit, QOpenGLTexture::ResetTextureUnit);
+                curAtlas = texture;
+            }
 
-                paintItem(pipe, item, is_standart_drawing);
+            // the atlased items differ by the layer and the rect only, so they share the bound texture (the indirect
+            // items take them from their data)
+            if (!isIndirect && (curLayer != region->layer || curRect != region->rect))
+            {
+                pipe->setAtlasRegion(region->layer, region->rect);
+                curLayer = region->layer;
+                curRect  = region->rect;
             }
         }
+
+        // the run of the indirect items is drawn by the single call
+        if (isIndirect)
+        {
+            const auto& count = static_cast<GLsizei>(run->end - run->begin);
+            setRenderAttributes(item->renderParameters.attributes);
+            if (!is_standart_drawing)
+            {
+                glDisable(GL_BLEND);
+            }
+
+            drawItem.indirectPipe->draw(item->renderParameters.mode, drawItem.geometry.isIndexed, run->first, count);
+            setRenderAttributes(is_standart_drawing ? mStandartRenderAttributes : mPickingRenderAttributes);
+
+            index = run->end - 1;
+            ++run;
+            continue;
+        }
+
+        paintItem(pipe, drawItem, is_standart_drawing);
+    }
+
+    if (mTransparentBegin < mVisibleItems.size())
+    {
+        glDepthMask(GL_TRUE);
+        setRenderAttributes(mStandartRenderAttributes);
     }
 }
 
-void GLSceneView::paintTextItems()
+void GLSceneView::paintBatches(const Camera& camera, const Light& light, bool is_standart_drawing,
+                               bool is_occlusion_culling)
 {
-    if (mIsTextVisible)
+    const auto& state   = camera.getState();
+    const auto& batches = mScene->getBatches();
+    auto hiddenSlot     = mHiddenSlots.cbegin();
+    for (size_t index{0}; index < batches.size() && index < mBatchPipes.size(); ++index)
     {
-        mGlassWidget->setItems(mScene->getTextItems());
+        const auto& batch = batches[index];
+        auto* pipe        = mBatchPipes[index].get();
+        while (hiddenSlot != mHiddenSlots.cend() && hiddenSlot->batch < index)
+        {
+            ++hiddenSlot;
+        }
+
+        // the batch is culled as the whole, the picking draws the items having the IDs only
+        if (!pipe || batch.frozenCount == 0 || (!is_standart_drawing && !batch.isPickable) ||
+            !state.isVisible(batch.min, batch.max) ||
+            (is_occlusion_culling && mOcclusionCuller.isOccluded(batch.min, batch.max)))
+        {
+            continue;
+        }
+
+        pipe->setSelection(!is_standart_drawing);
+        pipe->bind();
+        pipe->setLight(light);
+        pipe->setView(camera.getPosition(), camera.getProjection(), camera.getView());
+
+        // the region is resolved each frame, the texture could be loaded or packed into the atlas since the previous
+        const auto& region = mTextureManager->get(batch.textureId);
+        if (region.data && region.layer < 0)
+        {
+            region.data->bind();
+        }
+        else if (region.data)
+        {
+            region.data->bind(defaults::textures::kAtlasUnit, QOpenGLTexture::ResetTextureUnit);
+        }
+
+        pipe->setRegion(region.layer, region.rect);
+        setRenderAttributes(batch.renderParameters.attributes);
+        if (!is_standart_drawing)
+        {
+            glDisable(GL_BLEND);
+        }
+
+        // the highlighted items' vertices are skipped, the batch is drawn by the ranges between them
+        const auto& mode = batch.renderParameters.mode;
+        GLint first{0};
+        for (; hiddenSlot != mHiddenSlots.cend() && hiddenSlot->batch == index; ++hiddenSlot)
+        {
+            const auto& slot = batch.slots[hiddenSlot->slot];
+            pipe->draw(mode, first, slot.first - first);
+            first = slot.first + slot.count;
+        }
+
+        pipe->draw(mode, first, static_cast<GLsizei>(batch.vertices.size()) - first);
+        setRenderAttributes(is_standart_drawing ? mStandartRenderAttributes : mPickingRenderAttributes);
+        pipe->release();
     }
 }
 
-void GLSceneView::paintItem(PipeExt::Ptr pipe, Item::Ptr item, bool is_standart_drawing)
+void GLSceneView::sortTransparentItems(const Camera& camera)
 {
-    static Color oldColor;
-    static float oldAlfa;
-    static PipeExt::Ptr oldPipe;
-    int count;
-    int first;
-    Color color;
-
-    if (!is_standart_drawing && item->id == 0)
+    if (mTransparentItems.empty())
     {
         return;
     }
 
-    if (item->isMutableGeometry)
+    // the items start in the previous frame's order (the new ones go last), so the order is mostly right already
+    auto& order = mTransparentOrders[&camera];
+    mTransparentRanks.clear();
+    for (size_t rank{0}; rank < order.size(); ++rank)
     {
-        first = 0;
-        count = static_cast<int>(item->vertexPack.size());
-        pipe->allocate(item->vertexPack.data(), count * static_cast<int>(sizeof(Vertex)));
+        mTransparentRanks[order[rank]] = rank;
     }
-    else
+
+    std::vector<TransparentItem> ranked(order.size() + mTransparentItems.size(), {nullptr, 0.0f});
+    auto newRank     = order.size();
+    const auto* view = camera.getState().view.constData();
+    for (const auto& transparentItem : mTransparentItems)
     {
-        const auto& geometryData = mScene->getGeometryData(item->meshId);
-        first                    = geometryData.first;
-        count                    = geometryData.count;
+        const auto& drawItem = transparentItem.drawItem;
+        const auto& center   = (drawItem->geometry.min + drawItem->geometry.max) * 0.5f;
+        const auto& rankPair = mTransparentRanks.find(drawItem->item);
+        const auto& rank     = rankPair != mTransparentRanks.cend() ? rankPair->second : newRank++;
+        ranked[rank]         = {drawItem, view[2] * center.x() + view[6] * center.y() + view[10] * center.z() +
+                                    view[14]};
     }
 
-    if (is_standart_drawing)
+    // the view space z goes to the viewer, so the farthest item has the smallest one
+    mTransparentItems.clear();
+    for (const auto& transparentItem : ranked)
     {
-        int factor = 100;
+        if (transparentItem.drawItem)
+        {
+            mTransparentItems.push_back(transparentItem);
+        }
+    }
 
-        if (item->id != 0)
+    // the insertion sort is linear for the coherent frames, it gives way to the full sort if the order is lost
+    const auto& maxShiftCount = mTransparentItems.size() * kMaxTransparentShifts;
+    size_t shiftCount{0};
+    for (size_t index{1}; index < mTransparentItems.size() && shiftCount <= maxShiftCount; ++index)
+    {
+        const auto transparentItem = mTransparentItems[index];
+        auto position              = index;
+        for (; position > 0 && mTransparentItems[position - 1].viewZ > transparentItem.viewZ; --position)
         {
-            if (mSelectedItemIds.count(item->id))
-            {
-                factor = 190;
-            }
+            mTransparentItems[position] = mTransparentItems[position - 1];
+        }
 
-            if (item->id == mHoveredItemId)
+        shiftCount += index - position;
+        mTransparentItems[position] = transparentItem;
+    }
+
+    if (shiftCount > maxShiftCount)
+    {
+        std::stable_sort(mTransparentItems.begin(), mTransparentItems.end(),
+                         [](const auto& first, const auto& second) { return first.viewZ < second.viewZ; });
+    }
+
+    order.clear();
+    for (const auto& transparentItem : mTransparentItems)
+    {
+        order.push_back(transparentItem.drawItem->item);
+        mVisibleItems.push_back(transparentItem.drawItem);
+    }
+}
+
+QRect GLSceneView::toPixels(const QRectF& area, const QSize& size) const
+{
+    // the OpenGL's y goes up
+    const auto& width  = static_cast<qreal>(size.width());
+    const auto& height = static_cast<qreal>(size.height());
+    return {qRound(area.left() * width), qRound((1.0 - area.bottom()) * height), qRound(area.width() * width),
+            qRound(area.height() * height)};
+}
+
+void GLSceneView::resizeViewports()
+{
+    const auto& mainViewport = toPixels(mMainViewportArea, size());
+    mCamera.setViewPort(mainViewport.width(), mainViewport.height());
+
+    for (const auto& viewport : mViewports)
+    {
+        const auto& rect = toPixels(viewport.area, size());
+        viewport.camera->setViewPort(rect.width(), rect.height());
+    }
+}
+
+void GLSceneView::paintTextItems()
+{
+    if (mIsTextVisible)
+    {
+        const auto& pixelRatio = devicePixelRatioF();
+        const auto& textItems  = mScene->getTextItems();
+        mTextRenderer->update(textItems, mScene->getTextItemRevisions(), pixelRatio);
+
+        const auto& getBounds = [this](size_t index) { return mTextRenderer->getBounds(index); };
+        const auto& labels    = mLabelPlacer.place(textItems, mCamera.getTransformation(), size(), getBounds,
+                                                   mIsLabelOcclusion ? &readDepthMap() : nullptr);
+
+        // the text is drawn over the items within the same pass, so it neither blocks the frame nor lags behind it
+        setRenderAttributes(mTextRenderAttributes);
+        mTextRenderer->render(labels, size(), pixelRatio);
+        setRenderAttributes(mStandartRenderAttributes);
+    }
+}
+
+void GLSceneView::paintOverlay()
+{
+    if (mIsSelectionFrameVisible)
+    {
+        mOverlayRenderer->addFrame(QRectF(mSelectionRect.normalized()), defaults::colors::kSelectionRect);
+    }
+
+    setRenderAttributes(mTextRenderAttributes);
+    mOverlayRenderer->render(size());
+    setRenderAttributes(mStandartRenderAttributes);
+}
+
+QOpenGLFramebufferObject* GLSceneView::resolveDepth()
+{
+    // the scene buffer could be multisampled, so its depth is resolved into the single sampled one to be read
+    const auto& bufferSize = mSceneBuffer->size();
+    if (!mDepthBuffer || mDepthBuffer->size() != bufferSize)
+    {
+        QOpenGLFramebufferObjectFormat depthBufferFormat;
+        depthBufferFormat.setSamples(0);
+        depthBufferFormat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+        mDepthBuffer = std::make_shared<QOpenGLFramebufferObject>(bufferSize, depthBufferFormat);
+    }
+
+    auto* functions = context()->extraFunctions();
+    functions->glBindFramebuffer(GL_READ_FRAMEBUFFER, mSceneBuffer->handle());
+    functions->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mDepthBuffer->handle());
+    functions->glBlitFramebuffer(0, 0, bufferSize.width(), bufferSize.height(), 0, 0, bufferSize.width(),
+                                 bufferSize.height(), GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    return mDepthBuffer.get();
+}
+
+const LabelPlacer::DepthMap& GLSceneView::readDepthMap()
+{
+    // the depth is read back without waiting for the GPU, the labels are tested against one of the previous frames
+    auto* functions = context()->extraFunctions();
+    if (mDepthMapFence != nullptr)
+    {
+        const auto& status = functions->glClientWaitSync(mDepthMapFence, 0, 0);
+        if (status != GL_TIMEOUT_EXPIRED)
+        {
+            functions->glDeleteSync(mDepthMapFence);
+            mDepthMapFence = nullptr;
+        }
+
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+        {
+            mDepthMapBuffer.bind();
+            const auto& size  = mDepthMapBuffer.size();
+            const auto* depth = static_cast<const float*>(mDepthMapBuffer.mapRange(0, size, QOpenGLBuffer::RangeRead));
+            if (depth != nullptr)
             {
-                factor = factor != 100 ? 160 : 180;
+                mDepthMap.size = mDepthMapSize;
+                mDepthMap.depth.assign(depth, depth + mDepthMapSize.width() * mDepthMapSize.height());
+                mDepthMapBuffer.unmap();
             }
+            mDepthMapBuffer.release();
         }
+    }
+
+    // the frames go on until the depth of the latest change is read back
+    if (mIsDepthMapStale && mDepthMapFence == nullptr)
+    {
+        const auto* depthBuffer = resolveDepth();
+        const auto& size        = depthBuffer->size().width() * depthBuffer->size().height() * sizeof(float);
+        if (!mDepthMapBuffer.isCreated())
+        {
+            mDepthMapBuffer.setUsagePattern(QOpenGLBuffer::StreamRead);
+            mDepthMapBuffer.create();
+        }
+
+        mDepthMapBuffer.bind();
+        if (mDepthMapBuffer.size() != static_cast<int>(size))
+        {
+            mDepthMapBuffer.allocate(static_cast<int>(size));
+        }
+
+        functions->glBindFramebuffer(GL_READ_FRAMEBUFFER, depthBuffer->handle());
+        functions->glReadPixels(0, 0, depthBuffer->width(), depthBuffer->height(), GL_DEPTH_COMPONENT, GL_FLOAT,
+                                nullptr);
+        functions->glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+        mDepthMapBuffer.release();
 
-        color = item->color.lighter(factor);
+        mDepthMapFence   = functions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        mDepthMapSize    = depthBuffer->size();
+        mIsDepthMapStale = false;
     }
-    else
+
+    if (mIsDepthMapStale || mDepthMapFence != nullptr)
     {
-        color = item->id;
+        mFrameScheduler.invalidate(FrameScheduler::kDepthMap);
     }
 
-    if ((oldColor != color) || oldPipe != pipe)
+    return mDepthMap;
+}
+
+Color GLSceneView::getItemColor(const Item& item, bool is_standart_drawing) const
+{
+    if (!is_standart_drawing)
+    {
+        return item.id;
+    }
+
+    int factor = 100;
+
+    if (item.id != 0)
+    {
+        if (mSelectedItemIds.count(item.id))
+        {
+            factor = 190;
+        }
+
+        if (item.id == mHoveredItemId)
+        {
+            factor = factor != 100 ? 160 : 180;
+        }
+    }
+
+    return item.color.lighter(factor);
+}
+
+void GLSceneView::prepareIndirectRuns()
+{
+    // the blended items are drawn one by one in their sorted order
+    mIndirectRuns.clear();
+    for (size_t index{0}; index < mTransparentBegin; ++index)
+    {
+        const auto& drawItem = *mVisibleItems[index];
+        if (!drawItem.indirectPipe)
+        {
+            continue;
+        }
+
+        // the commands of the run are consecutive in the pipe's buffer as the run's items share the pipe
+        const auto& isNewRun = mIndirectRuns.empty() || mIndirectRuns.back().end != index ||
+                               !isSameRun(*mVisibleItems[index - 1], drawItem);
+        const auto& command  = drawItem.indirectPipe->addCommand(drawItem.geometry, drawItem.indirectIndex, isNewRun);
+        if (isNewRun)
+        {
+            mIndirectRuns.push_back({index, index + 1, command});
+        }
+        else
+        {
+            mIndirectRuns.back().end++;
+        }
+    }
+
+    for (const auto& indirectPair : mIndirectPipes)
+    {
+        indirectPair.second->uploadCommands();
+    }
+}
+
+bool GLSceneView::isHighlighted(const Item& item) const
+{
+    return item.id != 0 && (mSelectedItemIds.count(item.id) > 0 || item.id == mHoveredItemId);
+}
+
+bool GLSceneView::isSameRun(const DrawItem& first, const DrawItem& second) const
+{
+    const auto& firstParameters  = first.item->renderParameters;
+    const auto& secondParameters = second.item->renderParameters;
+    return first.indirectPipe == second.indirectPipe && first.geometry.isIndexed == second.geometry.isIndexed &&
+           first.region->data == second.region->data && firstParameters.mode == secondParameters.mode &&
+           firstParameters.attributes == secondParameters.attributes;
+}
+
+void GLSceneView::paintItem(PipeExt* pipe, const DrawItem& draw_item, bool is_standart_drawing)
+{
+    auto& uniforms         = mItemUniforms;
+    const auto& item       = draw_item.item;
+    const auto& first      = draw_item.geometry.first;
+    const auto& count      = draw_item.geometry.count;
+    const auto& isIndexed  = draw_item.geometry.isIndexed;
+    const auto& baseVertex = draw_item.geometry.baseVertex;
+    const auto& color      = getItemColor(*item, is_standart_drawing);
+
+    if ((uniforms.color != color) || uniforms.pipe != pipe)
     {
         pipe->setColor(color);
-        oldColor = color;
+        uniforms.color = color;
     }
 
     pipe->setTransform(item->transformation);
     setRenderAttributes(item->renderParameters.attributes);
 
-    if (oldAlfa != item->renderParameters.alfa || oldPipe != pipe)
+    if (uniforms.alfa != item->renderParameters.alfa || uniforms.pipe != pipe)
     {
         pipe->setAlfa(item->renderParameters.alfa);
-        oldAlfa = item->renderParameters.alfa;
+        uniforms.alfa = item->renderParameters.alfa;
     }
 
-    oldPipe = pipe;
+    uniforms.pipe = pipe;
 
     if (!is_standart_drawing)
     {
         glDisable(GL_BLEND);
     }
 
-    pipe->glDrawArrays(item->renderParameters.mode, first, count);
-    setRenderAttributes(is_standart_drawing ? mStandartRenderAttributes : mPickingRenderAttributes);
+    // without the base vertex draws the pipe's attributes are shifted instead
+    const auto& attributesShift = isIndexed && !mCapabilities.isBaseVertex ? baseVertex : 0;
+    if (pipe->getBaseVertex() != attributesShift)
+    {
+        pipe->setBaseVertex(attributesShift);
+    }
+
+    if (isIndexed && mCapabilities.isBaseVertex)
+    {
+        context()->extraFunctions()->glDrawElementsBaseVertex(
+            item->renderParameters.mode, count, GL_UNSIGNED_INT,
+            reinterpret_cast<void*>(sizeof(GLuint) * static_cast<uint>(first)), baseVertex);
+    }
+    else if (isIndexed)
+    {
+        pipe->glDrawElements(item->renderParameters.mode, count, GL_UNSIGNED_INT,
+                             reinterpret_cast<void*>(sizeof(GLuint) * static_cast<uint>(first)));
+    }
+    else
+    {
+        pipe->glDrawArrays(item->renderParameters.mode, first, count);
+    }
+    if (is_standart_drawing && item->renderParameters.alfa < 1.0f)
+    {
+        setRenderAttributes(mTransparentRenderAttributes);
+    }
+    else
+    {
+        setRenderAttributes(is_standart_drawing ? mStandartRenderAttributes : mPickingRenderAttributes);
+    }
 }
 
 void GLSceneView::cleanup()
 {
+    // the cleanup runs once per context (by its destruction or by the view's one), nothing is created without it
+    if (!mResourceManager)
+    {
+        return;
+    }
+
     makeCurrent();
+    mResourceManager->removeReadyCallback(this);
+    mStaticPipes.clear();
+    mDynamicPipes.clear();
+    mIndirectPipes.clear();
+    mBatchPipes.clear();
+    mOcclusionCuller.destroy();
+    if (mDepthMapFence != nullptr)
+    {
+        context()->extraFunctions()->glDeleteSync(mDepthMapFence);
+        mDepthMapFence = nullptr;
+    }
+    mDepthMapBuffer.destroy();
+    mDepthBuffer.reset();
+    mDepthMap        = {};
+    mIsDepthMapStale = true;
+    mTextureManager.reset();
+    mResourceManager.reset();
+    mTextRenderer.reset();
+    mOverlayRenderer.reset();
+    mSceneBuffer.reset();
+    for (auto& timer : mFrameTimers)
+    {
+        timer = {};
+    }
+    for (const auto& texture : mStreamingTextures)
+    {
+        texture->destroy();
+    }
     doneCurrent();
+
+    // the context outlives the view, its destruction mustn't call the cleanup of the destroyed view again
+    disconnect(context(), &QOpenGLContext::aboutToBeDestroyed, this, &GLSceneView::cleanup);
 }
 
 void GLSceneView::setRenderAttributes(const RenderAttributes& attributes)
@@ -363,14 +1330,21 @@ void GLSceneView::updateCursorShape()
     }
 }
 
+void GLSceneView::scheduleUpdate()
+{
+    // could be called from the worker threads, the invalidation is queued to the widget's thread
+    QMetaObject::invokeMethod(this, [this]() { mFrameScheduler.invalidate(FrameScheduler::kResources); });
+}
+
 void GLSceneView::mousePressEvent(QMouseEvent* event)
 {
     mManipulator->mousePressEvent(event, mCamera);
 
     mCurX = mPressedX = event->x();
     mCurY = mPressedY = event->y();
-    mGlassWidget->setFrameRect({QPoint{mPressedX, mPressedY}, QPoint{mCurX, mCurY}});
-    mGlassWidget->setFrameVisibility(mManipulator->isRectSelectionMode() || mManipulator->isRectZoomMode());
+    mSelectionRect           = {QPoint{mPressedX, mPressedY}, QPoint{mCurX, mCurY}};
+    mIsSelectionFrameVisible = mManipulator->isRectSelectionMode() || mManipulator->isRectZoomMode();
+    mFrameScheduler.invalidate(FrameScheduler::kOverlay);
 }
 
 void GLSceneView::mouseReleaseEvent(QMouseEvent* event)
@@ -387,7 +1361,8 @@ void GLSceneView::mouseReleaseEvent(QMouseEvent* event)
         }
     }
 
-    mGlassWidget->setFrameVisibility(false);
+    mIsSelectionFrameVisible = false;
+    mFrameScheduler.invalidate(FrameScheduler::kOverlay);
 
     mManipulator->mouseReleaseEvent(event, mCamera);
     updateCursorShape();
@@ -398,7 +1373,12 @@ void GLSceneView::mouseMoveEvent(QMouseEvent* event)
     mCurX = event->x();
     mCurY = event->y();
 
-    mGlassWidget->setFrameRect(QRect{QPoint{mPressedX, mPressedY}, QPoint{mCurX, mCurY}});
+    mSelectionRect = QRect{QPoint{mPressedX, mPressedY}, QPoint{mCurX, mCurY}};
+    if (mIsSelectionFrameVisible)
+    {
+        mFrameScheduler.invalidate(FrameScheduler::kOverlay);
+    }
+
     pickItems(mCurX, mCurY, mCurX, mCurY, 1, false);
 
     mCursorPosition = mCamera.toWorldXYCoordinates(mCurX, mCurY);